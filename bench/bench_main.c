@@ -0,0 +1,786 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "bench_report.h"
+#include "corpus.h"
+#include "entities.h"
+#include "extractor.h"
+#include "html_attrs.h"
+#include "html_scan.h"
+#include "simd_scan.h"
+#include "text_norm.h"
+#include "utils.h"
+#include "writer.h"
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#define CSV_BENCH_MIN_ARTICLES 20000
+
+static const char *const CLASS_NEEDLES[] = {
+    "tm-articles-list__item", "tm-publication-hubs", "tm-title__link",
+    "tm-user-info__username", "tm-publication-hub__link"
+};
+
+static const char *const ATTR_NAMES[] = {
+    "href", "class", "datetime"
+};
+
+typedef struct {
+    token_type_t type;
+    html_tag_t tag_id;
+    size_t tag_off;
+    size_t tag_len;
+    size_t data_off;
+    size_t data_len;
+} tape_entry_t;
+
+/* Tokens of the corpus, copied out of the scanner so the extractor can be
+ * measured without the tokenizer in the loop. */
+typedef struct {
+    tape_entry_t *entries;
+    size_t len;
+    size_t cap;
+    char *arena;
+    size_t arena_len;
+    size_t arena_cap;
+    token_t *tokens;
+    html_attrs_t attr_index;
+    bool failed;
+} token_tape_t;
+
+typedef struct {
+    const char *corpus;
+    size_t corpus_len;
+    size_t chunk_size;
+    token_tape_t tape;
+    size_t attr_bytes;
+    char *text_pool;
+    size_t text_pool_len;
+    char *text_scratch;
+    article_batch_t articles;
+    size_t csv_bytes;
+    FILE *null_out;
+    size_t tokens_seen;
+    size_t articles_seen;
+    size_t hits;
+    html_class_key_t class_keys[sizeof(CLASS_NEEDLES) / sizeof(CLASS_NEEDLES[0])];
+} bench_ctx_t;
+
+typedef void (*bench_fn)(bench_ctx_t *ctx);
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [run] [--fixture FILE] [--corpus FILE] [--size N[K|M|G]] [--seed N] [--chunk N]\n"
+            "     [--reps N] [--json FILE] [--baseline FILE] [--tolerance PCT]\n"
+            "  %s generate --output FILE [--fixture FILE] [--size N[K|M|G]] [--seed N]\n"
+            "     [--entity-rate N] [--attr-rate N] [--nest-rate N] [--attr-max N]\n",
+            prog, prog);
+}
+
+static double now_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static int read_file(const char *path, char **out_data, size_t *out_size) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t cap = 1 << 20;
+    size_t len = 0;
+    char *buffer = (char *)malloc(cap);
+    while (buffer) {
+        len += fread(buffer + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        cap *= 2;
+        char *grown = (char *)realloc(buffer, cap);
+        if (!grown) {
+            free(buffer);
+        }
+        buffer = grown;
+    }
+    bool failed = !buffer || ferror(fp);
+    fclose(fp);
+    if (failed) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(buffer);
+        return -1;
+    }
+    *out_data = buffer;
+    *out_size = len;
+    return 0;
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} mem_sink_t;
+
+static bool mem_sink_write(const char *data, size_t len, void *user_data) {
+    mem_sink_t *sink = (mem_sink_t *)user_data;
+    if (sink->len + len > sink->cap) {
+        size_t cap = sink->cap ? sink->cap : 1 << 20;
+        while (cap < sink->len + len) {
+            cap *= 2;
+        }
+        char *grown = (char *)realloc(sink->data, cap);
+        if (!grown) {
+            return false;
+        }
+        sink->data = grown;
+        sink->cap = cap;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    return true;
+}
+
+static bool file_sink_write(const char *data, size_t len, void *user_data) {
+    return fwrite(data, 1, len, (FILE *)user_data) == len;
+}
+
+static size_t tape_store(token_tape_t *tape, const char *data, size_t len) {
+    if (tape->arena_len + len + 1 > tape->arena_cap) {
+        size_t cap = tape->arena_cap ? tape->arena_cap : 1 << 20;
+        while (cap < tape->arena_len + len + 1) {
+            cap *= 2;
+        }
+        char *grown = (char *)realloc(tape->arena, cap);
+        if (!grown) {
+            tape->failed = true;
+            return 0;
+        }
+        tape->arena = grown;
+        tape->arena_cap = cap;
+    }
+    size_t offset = tape->arena_len;
+    memcpy(tape->arena + offset, data, len);
+    tape->arena[offset + len] = '\0';
+    tape->arena_len += len + 1;
+    return offset;
+}
+
+static bool tape_record(const token_t *token, void *user_data) {
+    token_tape_t *tape = (token_tape_t *)user_data;
+    if (tape->failed) {
+        return false;
+    }
+    if (tape->len == tape->cap) {
+        size_t cap = tape->cap ? tape->cap * 2 : 4096;
+        tape_entry_t *grown = (tape_entry_t *)realloc(tape->entries, cap * sizeof(tape_entry_t));
+        if (!grown) {
+            tape->failed = true;
+            return false;
+        }
+        tape->entries = grown;
+        tape->cap = cap;
+    }
+    tape_entry_t *entry = &tape->entries[tape->len++];
+    entry->type = token->type;
+    entry->tag_id = token->tag_id;
+    entry->tag_len = token->tag ? token->tag_len : 0;
+    entry->tag_off = tape_store(tape, token->tag ? token->tag : "", entry->tag_len);
+    const char *data = token->type == TOKEN_TEXT ? token->text : token->attrs;
+    entry->data_len = token->type == TOKEN_TEXT ? token->text_len : token->attrs_len;
+    entry->data_off = tape_store(tape, data ? data : "", entry->data_len);
+    return !tape->failed;
+}
+
+static int tape_build(token_tape_t *tape, const char *corpus, size_t corpus_len) {
+    memset(tape, 0, sizeof(*tape));
+    html_scanner_t scanner;
+    html_scanner_init(&scanner, tape_record, tape);
+    html_scanner_set_capture_text(&scanner, true);
+    html_scanner_feed(&scanner, corpus, corpus_len, true);
+    html_scanner_finish(&scanner);
+    html_scanner_free(&scanner);
+    if (tape->failed) {
+        return -1;
+    }
+    tape->tokens = (token_t *)calloc(tape->len ? tape->len : 1, sizeof(token_t));
+    if (!tape->tokens) {
+        return -1;
+    }
+    for (size_t i = 0; i < tape->len; ++i) {
+        const tape_entry_t *entry = &tape->entries[i];
+        token_t *token = &tape->tokens[i];
+        token->type = entry->type;
+        token->tag = entry->tag_len ? tape->arena + entry->tag_off : NULL;
+        token->tag_len = entry->tag_len;
+        token->tag_id = entry->tag_id;
+        if (entry->type == TOKEN_TEXT) {
+            token->text = tape->arena + entry->data_off;
+            token->text_len = entry->data_len;
+        } else {
+            token->attrs = tape->arena + entry->data_off;
+            token->attrs_len = entry->data_len;
+            token->attr_index = entry->type == TOKEN_START_TAG ? &tape->attr_index : NULL;
+        }
+    }
+    return 0;
+}
+
+static void tape_free(token_tape_t *tape) {
+    free(tape->entries);
+    free(tape->arena);
+    free(tape->tokens);
+}
+
+static bool is_blank(const char *text, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (text[i] != ' ' && text[i] != '\n' && text[i] != '\r' && text[i] != '\t') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Non-blank text runs, NUL-separated, as the extractor would decode them. */
+static int build_text_pool(bench_ctx_t *ctx) {
+    mem_sink_t pool = {NULL, 0, 0};
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type != TOKEN_TEXT || is_blank(token->text, token->text_len)) {
+            continue;
+        }
+        if (!mem_sink_write(token->text, token->text_len, &pool) || !mem_sink_write("", 1, &pool)) {
+            free(pool.data);
+            return -1;
+        }
+    }
+    if (!mem_sink_write("", 1, &pool)) {
+        free(pool.data);
+        return -1;
+    }
+    ctx->text_pool = pool.data;
+    ctx->text_pool_len = pool.len;
+    ctx->text_scratch = (char *)malloc(pool.len);
+    return ctx->text_scratch ? 0 : -1;
+}
+
+static arena_str_t fill_field(article_batch_t *batch, const char *text, size_t limit) {
+    size_t len = strlen(text);
+    return arena_strndup(&batch->arena, text, len < limit ? len : limit);
+}
+
+static arena_str_t format_field(article_batch_t *batch, const char *fmt, size_t n) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), fmt, n);
+    return arena_strndup(&batch->arena, buffer, strlen(buffer));
+}
+
+/* Articles for the CSV benchmark, with titles taken from the corpus text so
+ * quotes and non-ASCII bytes occur at realistic rates. */
+static int build_articles(bench_ctx_t *ctx, size_t count) {
+    if (count < CSV_BENCH_MIN_ARTICLES) {
+        count = CSV_BENCH_MIN_ARTICLES;
+    }
+    article_batch_t *batch = &ctx->articles;
+    article_batch_init(batch);
+    const char *text = ctx->text_pool;
+    const char *pool_end = ctx->text_pool + ctx->text_pool_len;
+    ctx->csv_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        article_t *article = article_batch_push(batch);
+        if (!article) {
+            return -1;
+        }
+        if (text >= pool_end || *text == '\0') {
+            text = ctx->text_pool;
+        }
+        article->title = fill_field(batch, text, 160);
+        text += strlen(text) + 1;
+        article->url = format_field(batch, "https://habr.com/en/articles/%zu/", 900000 + i);
+        article->date = format_field(batch, "2025-11-%02zu", 1 + i % 28);
+        article->author = format_field(batch, "author_%zu", i % 997);
+        article->tags = format_field(batch, "Go, Programming, \"%zu\" hub", i % 31);
+
+        const arena_str_t fields[] = {article->title, article->url, article->date, article->author, article->tags};
+        for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); ++f) {
+            ctx->csv_bytes += 3 + fields[f].len;
+            for (size_t c = 0; c < fields[f].len; ++c) {
+                ctx->csv_bytes += fields[f].data[c] == '"';
+            }
+        }
+    }
+    return 0;
+}
+
+static bool count_token(const token_t *token, void *user_data) {
+    (void)token;
+    ++((bench_ctx_t *)user_data)->tokens_seen;
+    return true;
+}
+
+static void run_scanner(bench_ctx_t *ctx) {
+    html_scanner_t scanner;
+    html_scanner_init(&scanner, count_token, ctx);
+    html_scanner_set_capture_text(&scanner, true);
+    ctx->tokens_seen = 0;
+    for (size_t offset = 0; offset < ctx->corpus_len; offset += ctx->chunk_size) {
+        size_t len = ctx->corpus_len - offset;
+        if (len > ctx->chunk_size) {
+            len = ctx->chunk_size;
+        }
+        html_scanner_feed(&scanner, ctx->corpus + offset, len, offset + len == ctx->corpus_len);
+    }
+    html_scanner_finish(&scanner);
+    html_scanner_free(&scanner);
+}
+
+static void run_process_token(bench_ctx_t *ctx) {
+    extractor_t extractor;
+    if (!extractor_init(&extractor, NULL, 0)) {
+        return;
+    }
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type == TOKEN_START_TAG) {
+            html_attrs_reset(&ctx->tape.attr_index, token->attrs, token->attrs_len);
+        }
+        extractor_process_token(&extractor, token);
+    }
+    ctx->articles_seen = extractor_get_count(&extractor);
+    extractor_free(&extractor);
+}
+
+static void run_consume_html(bench_ctx_t *ctx) {
+    extractor_t extractor;
+    if (!extractor_init(&extractor, NULL, 0)) {
+        return;
+    }
+    extractor_begin_document(&extractor);
+    for (size_t offset = 0; offset < ctx->corpus_len; offset += ctx->chunk_size) {
+        size_t len = ctx->corpus_len - offset;
+        extractor_feed(&extractor, ctx->corpus + offset, len < ctx->chunk_size ? len : ctx->chunk_size);
+    }
+    extractor_end_document(&extractor);
+    ctx->articles_seen = extractor_get_count(&extractor);
+    extractor_free(&extractor);
+}
+
+static void run_entities(bench_ctx_t *ctx) {
+    memcpy(ctx->text_scratch, ctx->text_pool, ctx->text_pool_len);
+    char *end = ctx->text_scratch + ctx->text_pool_len - 1;
+    for (char *p = ctx->text_scratch; p < end; ) {
+        size_t len = strlen(p);
+        entities_decode_inplace(p);
+        p += len + 1;
+    }
+}
+
+static void run_text_normalize(bench_ctx_t *ctx) {
+    memcpy(ctx->text_scratch, ctx->text_pool, ctx->text_pool_len);
+    char *end = ctx->text_scratch + ctx->text_pool_len - 1;
+    for (char *p = ctx->text_scratch; p < end; ) {
+        size_t len = strlen(p);
+        text_normalize(p, len, true);
+        p += len + 1;
+    }
+}
+
+static void run_parse_attr(bench_ctx_t *ctx) {
+    char value[1024];
+    size_t hits = 0;
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type != TOKEN_START_TAG) {
+            continue;
+        }
+        for (size_t n = 0; n < sizeof(ATTR_NAMES) / sizeof(ATTR_NAMES[0]); ++n) {
+            hits += (size_t)utils_parse_attr(token->attrs, token->attrs_len, ATTR_NAMES[n], value, sizeof(value));
+        }
+    }
+    ctx->hits = hits;
+}
+
+static void run_attr_index(bench_ctx_t *ctx) {
+    size_t hits = 0;
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type != TOKEN_START_TAG) {
+            continue;
+        }
+        html_attrs_reset(&ctx->tape.attr_index, token->attrs, token->attrs_len);
+        for (size_t n = 0; n < sizeof(ATTR_NAMES) / sizeof(ATTR_NAMES[0]); ++n) {
+            const char *value = NULL;
+            size_t value_len = 0;
+            hits += html_attrs_get(&ctx->tape.attr_index, ATTR_NAMES[n], &value, &value_len);
+        }
+    }
+    ctx->hits = hits;
+}
+
+static void run_class_contains(bench_ctx_t *ctx) {
+    size_t hits = 0;
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type != TOKEN_START_TAG) {
+            continue;
+        }
+        for (size_t n = 0; n < sizeof(CLASS_NEEDLES) / sizeof(CLASS_NEEDLES[0]); ++n) {
+            hits += utils_class_contains(token->attrs, token->attrs_len, CLASS_NEEDLES[n]);
+        }
+    }
+    ctx->hits = hits;
+}
+
+static void run_class_set(bench_ctx_t *ctx) {
+    size_t hits = 0;
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        const token_t *token = &ctx->tape.tokens[i];
+        if (token->type != TOKEN_START_TAG) {
+            continue;
+        }
+        html_attrs_reset(&ctx->tape.attr_index, token->attrs, token->attrs_len);
+        for (size_t n = 0; n < sizeof(CLASS_NEEDLES) / sizeof(CLASS_NEEDLES[0]); ++n) {
+            hits += html_attrs_has_class(&ctx->tape.attr_index, &ctx->class_keys[n]);
+        }
+    }
+    ctx->hits = hits;
+}
+
+static void run_csv_writer(bench_ctx_t *ctx) {
+    writer_t writer;
+    if (!writer_init(&writer, &writer_csv_ops, ctx->null_out)) {
+        return;
+    }
+    writer_write_batch(&writer, &ctx->articles);
+    writer_end(&writer);
+    writer_free(&writer);
+}
+
+/* Best wall time over `reps` runs after one warm-up run. */
+static double time_best(bench_ctx_t *ctx, bench_fn fn, int reps) {
+    fn(ctx);
+    double best = 0;
+    for (int i = 0; i < reps; ++i) {
+        double start = now_seconds();
+        fn(ctx);
+        double elapsed = now_seconds() - start;
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best > 0 ? best : 1e-9;
+}
+
+static bool report(bench_results_t *results, const char *name, double bytes, double articles, double seconds) {
+    bool ok = bench_results_add(results, name, "MB/s", bytes / seconds / 1e6);
+    if (ok && articles > 0) {
+        ok = bench_results_add(results, name, "articles/s", articles / seconds);
+    }
+    return ok;
+}
+
+static int run_benchmarks(bench_ctx_t *ctx, int reps, bench_results_t *results) {
+    double seconds = time_best(ctx, run_scanner, reps);
+    if (!report(results, "html_scanner_feed", (double)ctx->corpus_len, 0, seconds) ||
+        !bench_results_add(results, "html_scanner_feed", "Mtokens/s", (double)ctx->tokens_seen / seconds / 1e6)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_process_token, reps);
+    if (!report(results, "extractor_process_token", (double)ctx->corpus_len, (double)ctx->articles_seen, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_consume_html, reps);
+    if (!report(results, "extractor_pipeline", (double)ctx->corpus_len, (double)ctx->articles_seen, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_entities, reps);
+    if (!report(results, "entities_decode_inplace", (double)ctx->text_pool_len, 0, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_text_normalize, reps);
+    if (!report(results, "text_normalize", (double)ctx->text_pool_len, 0, seconds)) {
+        return -1;
+    }
+
+    size_t attr_names = sizeof(ATTR_NAMES) / sizeof(ATTR_NAMES[0]);
+    seconds = time_best(ctx, run_parse_attr, reps);
+    if (!report(results, "utils_parse_attr", (double)(ctx->attr_bytes * attr_names), 0, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_attr_index, reps);
+    if (!report(results, "html_attrs_get", (double)(ctx->attr_bytes * attr_names), 0, seconds)) {
+        return -1;
+    }
+
+    size_t needles = sizeof(CLASS_NEEDLES) / sizeof(CLASS_NEEDLES[0]);
+    seconds = time_best(ctx, run_class_contains, reps);
+    if (!report(results, "utils_class_contains", (double)(ctx->attr_bytes * needles), 0, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_class_set, reps);
+    if (!report(results, "html_attrs_has_class", (double)(ctx->attr_bytes * needles), 0, seconds)) {
+        return -1;
+    }
+
+    seconds = time_best(ctx, run_csv_writer, reps);
+    if (!report(results, "csv_writer_write", (double)ctx->csv_bytes, (double)ctx->articles.len, seconds)) {
+        return -1;
+    }
+    return 0;
+}
+
+static void bench_ctx_free(bench_ctx_t *ctx) {
+    if (ctx->null_out) {
+        fclose(ctx->null_out);
+    }
+    tape_free(&ctx->tape);
+    free(ctx->text_pool);
+    free(ctx->text_scratch);
+    article_batch_free(&ctx->articles);
+}
+
+static int prepare_inputs(bench_ctx_t *ctx) {
+    if (tape_build(&ctx->tape, ctx->corpus, ctx->corpus_len) != 0 || build_text_pool(ctx) != 0) {
+        fprintf(stderr, "Failed to prepare benchmark inputs\n");
+        return -1;
+    }
+    for (size_t i = 0; i < ctx->tape.len; ++i) {
+        if (ctx->tape.tokens[i].type == TOKEN_START_TAG) {
+            ctx->attr_bytes += ctx->tape.tokens[i].attrs_len;
+        }
+    }
+    for (size_t n = 0; n < sizeof(CLASS_NEEDLES) / sizeof(CLASS_NEEDLES[0]); ++n) {
+        html_class_key_init(&ctx->class_keys[n], CLASS_NEEDLES[n]);
+    }
+    run_process_token(ctx);
+    if (build_articles(ctx, ctx->articles_seen) != 0) {
+        fprintf(stderr, "Failed to prepare benchmark inputs\n");
+        return -1;
+    }
+    ctx->null_out = fopen(NULL_DEVICE, "wb");
+    if (!ctx->null_out) {
+        fprintf(stderr, "Failed to open %s: %s\n", NULL_DEVICE, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int load_corpus(const char *fixture_path, const char *corpus_path, const corpus_options_t *options,
+                       char **out_data, size_t *out_size) {
+    if (corpus_path) {
+        return read_file(corpus_path, out_data, out_size);
+    }
+    char *fixture = NULL;
+    size_t fixture_len = 0;
+    if (read_file(fixture_path, &fixture, &fixture_len) != 0) {
+        return -1;
+    }
+    mem_sink_t sink = {NULL, 0, 0};
+    int rc = corpus_generate(fixture, fixture_len, options, mem_sink_write, &sink);
+    free(fixture);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to generate corpus\n");
+        free(sink.data);
+        return -1;
+    }
+    *out_data = sink.data;
+    *out_size = sink.len;
+    return 0;
+}
+
+static int run_command(const char *fixture_path, const char *corpus_path, const corpus_options_t *corpus_options,
+                       size_t chunk_size, int reps, const char *json_path, const char *baseline_path,
+                       double tolerance) {
+    char *corpus = NULL;
+    size_t corpus_len = 0;
+    if (load_corpus(fixture_path, corpus_path, corpus_options, &corpus, &corpus_len) != 0) {
+        return 1;
+    }
+    bench_results_t baseline;
+    bench_results_init(&baseline);
+    if (baseline_path && bench_results_read_json(&baseline, baseline_path) != 0) {
+        free(corpus);
+        return 1;
+    }
+
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.corpus = corpus;
+    ctx.corpus_len = corpus_len;
+    ctx.chunk_size = chunk_size;
+    bench_results_t results;
+    bench_results_init(&results);
+
+    int exit_code = 1;
+    const char *simd = simd_scan_kernels()->name;
+    if (prepare_inputs(&ctx) == 0) {
+        printf("corpus: %zu bytes, %zu tokens, %zu articles, simd: %s\n\n",
+               corpus_len, ctx.tape.len, ctx.articles_seen, simd);
+        if (run_benchmarks(&ctx, reps, &results) == 0) {
+            bench_results_print(&results);
+            exit_code = 0;
+        } else {
+            fprintf(stderr, "Out of memory\n");
+        }
+    }
+    if (exit_code == 0 && json_path && bench_results_write_json(&results, json_path, simd, corpus_len) != 0) {
+        exit_code = 1;
+    }
+    if (exit_code == 0 && baseline_path) {
+        size_t regressions = bench_results_compare(&results, &baseline, tolerance);
+        if (regressions > 0) {
+            fprintf(stderr, "%zu result(s) regressed more than %.1f%% against %s\n",
+                    regressions, tolerance, baseline_path);
+            exit_code = 2;
+        }
+    }
+
+    bench_ctx_free(&ctx);
+    bench_results_free(&results);
+    bench_results_free(&baseline);
+    free(corpus);
+    return exit_code;
+}
+
+static int generate_command(const char *fixture_path, const char *output_path, const corpus_options_t *options) {
+    char *fixture = NULL;
+    size_t fixture_len = 0;
+    if (read_file(fixture_path, &fixture, &fixture_len) != 0) {
+        return 1;
+    }
+    FILE *out = fopen(output_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s: %s\n", output_path, strerror(errno));
+        free(fixture);
+        return 1;
+    }
+    int rc = corpus_generate(fixture, fixture_len, options, file_sink_write, out);
+    free(fixture);
+    if (fclose(out) != 0 || rc != 0) {
+        fprintf(stderr, "Failed to write %s\n", output_path);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *fixture_path = "tests/fixtures/habr_example.html";
+    const char *corpus_path = NULL;
+    const char *output_path = NULL;
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    double tolerance = 5.0;
+    size_t chunk_size = 16 * 1024;
+    int reps = 5;
+    corpus_options_t corpus_options;
+    corpus_options_init(&corpus_options);
+
+    int first = 1;
+    bool generate = false;
+    if (argc > 1 && strcmp(argv[1], "generate") == 0) {
+        generate = true;
+        first = 2;
+    } else if (argc > 1 && strcmp(argv[1], "run") == 0) {
+        first = 2;
+    }
+
+    for (int i = first; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(arg, "--fixture") == 0) {
+            fixture_path = value;
+        } else if (strcmp(arg, "--corpus") == 0) {
+            corpus_path = value;
+        } else if (strcmp(arg, "--output") == 0 || strcmp(arg, "-o") == 0) {
+            output_path = value;
+        } else if (strcmp(arg, "--json") == 0) {
+            json_path = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            baseline_path = value;
+        } else if (strcmp(arg, "--size") == 0) {
+            if (!corpus_parse_size(value, &corpus_options.target_size)) {
+                fprintf(stderr, "Invalid --size: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--seed") == 0) {
+            corpus_options.seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--chunk") == 0) {
+            if (!corpus_parse_size(value, &chunk_size)) {
+                fprintf(stderr, "Invalid --chunk: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--reps") == 0) {
+            reps = (int)strtol(value, NULL, 10);
+            if (reps <= 0) {
+                fprintf(stderr, "--reps must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            tolerance = strtod(value, NULL);
+            if (tolerance < 0) {
+                fprintf(stderr, "--tolerance must be non-negative\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--entity-rate") == 0) {
+            corpus_options.entity_rate = (int)strtol(value, NULL, 10);
+        } else if (strcmp(arg, "--attr-rate") == 0) {
+            corpus_options.long_attr_rate = (int)strtol(value, NULL, 10);
+        } else if (strcmp(arg, "--nest-rate") == 0) {
+            corpus_options.nest_rate = (int)strtol(value, NULL, 10);
+        } else if (strcmp(arg, "--attr-max") == 0) {
+            corpus_options.long_attr_max = (size_t)strtoull(value, NULL, 10);
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (generate) {
+        if (!output_path) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return generate_command(fixture_path, output_path, &corpus_options);
+    }
+    return run_command(fixture_path, corpus_path, &corpus_options, chunk_size, reps, json_path, baseline_path,
+                       tolerance);
+}
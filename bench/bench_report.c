@@ -0,0 +1,142 @@
+#include "bench_report.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+void bench_results_init(bench_results_t *results) {
+    results->items = NULL;
+    results->len = 0;
+    results->cap = 0;
+}
+
+void bench_results_free(bench_results_t *results) {
+    free(results->items);
+    bench_results_init(results);
+}
+
+bool bench_results_add(bench_results_t *results, const char *name, const char *unit, double value) {
+    if (results->len == results->cap) {
+        size_t cap = results->cap ? results->cap * 2 : 16;
+        bench_result_t *grown = (bench_result_t *)realloc(results->items, cap * sizeof(bench_result_t));
+        if (!grown) {
+            return false;
+        }
+        results->items = grown;
+        results->cap = cap;
+    }
+    bench_result_t *item = &results->items[results->len++];
+    utils_copy_string(item->name, sizeof(item->name), name);
+    utils_copy_string(item->unit, sizeof(item->unit), unit);
+    item->value = value;
+    return true;
+}
+
+void bench_results_print(const bench_results_t *results) {
+    for (size_t i = 0; i < results->len; ++i) {
+        const bench_result_t *item = &results->items[i];
+        printf("%-28s %14.2f %s\n", item->name, item->value, item->unit);
+    }
+}
+
+int bench_results_write_json(const bench_results_t *results, const char *path, const char *simd,
+                             size_t corpus_bytes) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(fp, "{\n  \"format\": 1,\n  \"simd\": \"%s\",\n  \"corpus_bytes\": %zu,\n  \"results\": [\n",
+            simd, corpus_bytes);
+    for (size_t i = 0; i < results->len; ++i) {
+        const bench_result_t *item = &results->items[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.2f}%s\n",
+                item->name, item->unit, item->value, i + 1 < results->len ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static bool read_string_field(const char *line, const char *key, char *out, size_t cap) {
+    const char *p = strstr(line, key);
+    if (!p) {
+        return false;
+    }
+    p = strchr(p + strlen(key), '"');
+    if (!p) {
+        return false;
+    }
+    const char *end = strchr(++p, '"');
+    if (!end) {
+        return false;
+    }
+    out[0] = '\0';
+    return utils_safe_append_n(out, cap, p, (size_t)(end - p));
+}
+
+int bench_results_read_json(bench_results_t *results, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        char name[BENCH_NAME_CAP];
+        char unit[BENCH_UNIT_CAP];
+        const char *value = strstr(line, "\"value\":");
+        if (!value || !read_string_field(line, "\"name\":", name, sizeof(name)) ||
+            !read_string_field(line, "\"unit\":", unit, sizeof(unit))) {
+            continue;
+        }
+        if (!bench_results_add(results, name, unit, strtod(value + strlen("\"value\":"), NULL))) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    if (results->len == 0) {
+        fprintf(stderr, "No results found in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static const bench_result_t *find_result(const bench_results_t *results, const bench_result_t *key) {
+    for (size_t i = 0; i < results->len; ++i) {
+        const bench_result_t *item = &results->items[i];
+        if (strcmp(item->name, key->name) == 0 && strcmp(item->unit, key->unit) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+size_t bench_results_compare(const bench_results_t *current, const bench_results_t *baseline,
+                             double tolerance_pct) {
+    size_t regressions = 0;
+    printf("\n%-28s %14s %14s %9s\n", "benchmark", "baseline", "current", "change");
+    for (size_t i = 0; i < current->len; ++i) {
+        const bench_result_t *item = &current->items[i];
+        const bench_result_t *base = find_result(baseline, item);
+        if (!base || base->value <= 0) {
+            printf("%-28s %14s %14.2f %9s  %s\n", item->name, "-", item->value, "-", item->unit);
+            continue;
+        }
+        double change = (item->value - base->value) / base->value * 100.0;
+        bool regressed = change < -tolerance_pct;
+        if (regressed) {
+            ++regressions;
+        }
+        printf("%-28s %14.2f %14.2f %+8.1f%%  %s%s\n", item->name, base->value, item->value, change,
+               item->unit, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
@@ -0,0 +1,42 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BENCH_NAME_CAP 64
+#define BENCH_UNIT_CAP 16
+
+typedef struct {
+    char name[BENCH_NAME_CAP];
+    char unit[BENCH_UNIT_CAP];
+    double value;
+} bench_result_t;
+
+typedef struct {
+    bench_result_t *items;
+    size_t len;
+    size_t cap;
+} bench_results_t;
+
+void bench_results_init(bench_results_t *results);
+void bench_results_free(bench_results_t *results);
+bool bench_results_add(bench_results_t *results, const char *name, const char *unit, double value);
+void bench_results_print(const bench_results_t *results);
+
+/*
+ * Results files are JSON with one result object per line, e.g.
+ *   {"name": "html_scanner_feed", "unit": "MB/s", "value": 1093.21}
+ * so that a baseline written by habr_bench can be read back without a JSON
+ * library. Higher values are always better.
+ */
+int bench_results_write_json(const bench_results_t *results, const char *path, const char *simd,
+                             size_t corpus_bytes);
+int bench_results_read_json(bench_results_t *results, const char *path);
+
+/* Prints each result against the baseline; returns the number of results that
+ * fell more than tolerance_pct below it. */
+size_t bench_results_compare(const bench_results_t *current, const bench_results_t *baseline,
+                             double tolerance_pct);
+
+#endif
@@ -0,0 +1,314 @@
+#include "corpus.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CORPUS_OUT_CAP (64 * 1024)
+
+typedef struct {
+    char buf[CORPUS_OUT_CAP];
+    size_t len;
+    size_t total;
+    bool failed;
+    corpus_write_fn write;
+    void *user_data;
+} corpus_out_t;
+
+typedef struct {
+    const corpus_options_t *options;
+    uint64_t rng;
+    corpus_out_t out;
+} corpus_state_t;
+
+static const char *const ENTITY_SAMPLES[] = {
+    "&amp;", "&lt;", "&gt;", "&nbsp;", "&#8212;", "&#x41;", "&#1046;", "&quot;", "&bogus;", "& "
+};
+
+static const char *const NEST_TAGS[] = {
+    "span", "em", "b", "i", "strong"
+};
+
+static uint64_t next_random(corpus_state_t *state) {
+    uint64_t z = (state->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static bool chance(corpus_state_t *state, int per_mille) {
+    return per_mille > 0 && (int)(next_random(state) % 1000) < per_mille;
+}
+
+static void out_flush(corpus_out_t *out) {
+    if (out->len > 0 && !out->failed && !out->write(out->buf, out->len, out->user_data)) {
+        out->failed = true;
+    }
+    out->len = 0;
+}
+
+static void out_write(corpus_out_t *out, const char *data, size_t len) {
+    out->total += len;
+    while (len > 0) {
+        size_t room = CORPUS_OUT_CAP - out->len;
+        size_t take = len < room ? len : room;
+        memcpy(out->buf + out->len, data, take);
+        out->len += take;
+        data += take;
+        len -= take;
+        if (out->len == CORPUS_OUT_CAP) {
+            out_flush(out);
+        }
+    }
+}
+
+static void out_str(corpus_out_t *out, const char *text) {
+    out_write(out, text, strlen(text));
+}
+
+static void emit_long_attr(corpus_state_t *state) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_ >'/=";
+    size_t max = state->options->long_attr_max > 16 ? state->options->long_attr_max : 16;
+    size_t len = 16 + (size_t)(next_random(state) % (max - 15));
+    char chunk[256];
+    out_str(&state->out, " data-bench=\"");
+    while (len > 0) {
+        size_t take = len < sizeof(chunk) ? len : sizeof(chunk);
+        for (size_t i = 0; i < take; ++i) {
+            chunk[i] = alphabet[next_random(state) % (sizeof(alphabet) - 1)];
+        }
+        out_write(&state->out, chunk, take);
+        len -= take;
+    }
+    out_str(&state->out, "\"");
+}
+
+static void emit_text(corpus_state_t *state, const char *text, size_t len) {
+    int rate = state->options->entity_rate;
+    size_t plain = 0;
+    for (size_t i = 0; i < len; ++i) {
+        bool space = text[i] == ' ';
+        if (!(space ? chance(state, rate) : chance(state, rate / 4))) {
+            continue;
+        }
+        out_write(&state->out, text + plain, i - plain);
+        plain = i;
+        if (space) {
+            out_str(&state->out, "&nbsp;");
+            plain = i + 1;
+        } else {
+            size_t count = sizeof(ENTITY_SAMPLES) / sizeof(ENTITY_SAMPLES[0]);
+            out_str(&state->out, ENTITY_SAMPLES[next_random(state) % count]);
+        }
+    }
+    out_write(&state->out, text + plain, len - plain);
+}
+
+static bool is_blank(const char *text, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (!isspace((unsigned char)text[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void emit_text_run(corpus_state_t *state, const char *text, size_t len) {
+    if (is_blank(text, len)) {
+        out_write(&state->out, text, len);
+        return;
+    }
+    if (!chance(state, state->options->nest_rate)) {
+        emit_text(state, text, len);
+        return;
+    }
+    size_t tag_count = sizeof(NEST_TAGS) / sizeof(NEST_TAGS[0]);
+    size_t depth = 1 + (size_t)(next_random(state) % 4);
+    size_t picks[4];
+    for (size_t i = 0; i < depth; ++i) {
+        picks[i] = (size_t)(next_random(state) % tag_count);
+        out_str(&state->out, "<");
+        out_str(&state->out, NEST_TAGS[picks[i]]);
+        out_str(&state->out, ">");
+    }
+    emit_text(state, text, len);
+    for (size_t i = depth; i-- > 0; ) {
+        out_str(&state->out, "</");
+        out_str(&state->out, NEST_TAGS[picks[i]]);
+        out_str(&state->out, ">");
+    }
+}
+
+/* Index of the '>' that closes the tag starting at `start`, honoring quotes. */
+static size_t tag_end(const char *card, size_t len, size_t start) {
+    char quote = 0;
+    for (size_t i = start; i < len; ++i) {
+        char c = card[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i;
+        }
+    }
+    return len - 1;
+}
+
+static void emit_card(corpus_state_t *state, const char *card, size_t len) {
+    size_t i = 0;
+    while (i < len && !state->out.failed) {
+        if (card[i] != '<') {
+            size_t start = i;
+            while (i < len && card[i] != '<') {
+                ++i;
+            }
+            emit_text_run(state, card + start, i - start);
+            continue;
+        }
+        if (len - i >= 4 && memcmp(card + i, "<!--", 4) == 0) {
+            const char *close = NULL;
+            for (size_t j = i + 4; j + 3 <= len; ++j) {
+                if (memcmp(card + j, "-->", 3) == 0) {
+                    close = card + j + 3;
+                    break;
+                }
+            }
+            size_t end = close ? (size_t)(close - card) : len;
+            out_write(&state->out, card + i, end - i);
+            i = end;
+            continue;
+        }
+        size_t end = tag_end(card, len, i + 1);
+        if (i + 1 < len && isalpha((unsigned char)card[i + 1])) {
+            size_t name_end = i + 1;
+            while (name_end < end && (isalnum((unsigned char)card[name_end]) || card[name_end] == '-')) {
+                ++name_end;
+            }
+            out_write(&state->out, card + i, name_end - i);
+            if (chance(state, state->options->long_attr_rate)) {
+                emit_long_attr(state);
+            }
+            out_write(&state->out, card + name_end, end + 1 - name_end);
+        } else {
+            out_write(&state->out, card + i, end + 1 - i);
+        }
+        i = end + 1;
+    }
+}
+
+static const char *find_bytes(const char *hay, size_t hay_len, const char *needle) {
+    size_t needle_len = strlen(needle);
+    for (size_t i = 0; i + needle_len <= hay_len; ++i) {
+        if (memcmp(hay + i, needle, needle_len) == 0) {
+            return hay + i;
+        }
+    }
+    return NULL;
+}
+
+void corpus_options_init(corpus_options_t *options) {
+    options->target_size = 16u * 1024u * 1024u;
+    options->seed = 1;
+    options->entity_rate = 20;
+    options->long_attr_rate = 10;
+    options->nest_rate = 100;
+    options->long_attr_max = 4096;
+}
+
+int corpus_generate(const char *fixture, size_t fixture_len, const corpus_options_t *options,
+                    corpus_write_fn write, void *user_data) {
+    size_t card_cap = 64;
+    size_t card_count = 0;
+    size_t *starts = (size_t *)malloc(card_cap * sizeof(size_t));
+    if (!starts) {
+        return -1;
+    }
+    size_t cards_end = 0;
+    const char *p = fixture;
+    const char *end = fixture + fixture_len;
+    while ((p = find_bytes(p, (size_t)(end - p), "<article")) != NULL) {
+        const char *close = find_bytes(p, (size_t)(end - p), "</article>");
+        if (!close) {
+            break;
+        }
+        if (card_count == card_cap) {
+            card_cap *= 2;
+            size_t *grown = (size_t *)realloc(starts, card_cap * sizeof(size_t));
+            if (!grown) {
+                free(starts);
+                return -1;
+            }
+            starts = grown;
+        }
+        starts[card_count++] = (size_t)(p - fixture);
+        p = close + strlen("</article>");
+        cards_end = (size_t)(p - fixture);
+    }
+    if (card_count == 0) {
+        fprintf(stderr, "No article cards found in the fixture\n");
+        free(starts);
+        return -1;
+    }
+
+    corpus_state_t *state = (corpus_state_t *)malloc(sizeof(corpus_state_t));
+    if (!state) {
+        free(starts);
+        return -1;
+    }
+    state->options = options;
+    state->rng = options->seed;
+    state->out.len = 0;
+    state->out.total = 0;
+    state->out.failed = false;
+    state->out.write = write;
+    state->out.user_data = user_data;
+
+    size_t suffix_len = fixture_len - cards_end;
+    out_write(&state->out, fixture, starts[0]);
+    do {
+        size_t index = (size_t)(next_random(state) % card_count);
+        size_t card_end = index + 1 < card_count ? starts[index + 1] : cards_end;
+        emit_card(state, fixture + starts[index], card_end - starts[index]);
+    } while (!state->out.failed && state->out.total + suffix_len < options->target_size);
+    out_write(&state->out, fixture + cards_end, suffix_len);
+    out_flush(&state->out);
+
+    int rc = state->out.failed ? -1 : 0;
+    free(state);
+    free(starts);
+    return rc;
+}
+
+bool corpus_parse_size(const char *text, size_t *out) {
+    char *end = NULL;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0) {
+        return false;
+    }
+    double scale = 1;
+    switch (toupper((unsigned char)*end)) {
+        case 'K':
+            scale = 1024.0;
+            ++end;
+            break;
+        case 'M':
+            scale = 1024.0 * 1024.0;
+            ++end;
+            break;
+        case 'G':
+            scale = 1024.0 * 1024.0 * 1024.0;
+            ++end;
+            break;
+        default:
+            break;
+    }
+    if (*end != '\0' && !((*end == 'B' || *end == 'b') && end[1] == '\0')) {
+        return false;
+    }
+    *out = (size_t)(value * scale);
+    return *out > 0;
+}
@@ -0,0 +1,33 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Receives generated bytes; returns false to abort generation. */
+typedef bool (*corpus_write_fn)(const char *data, size_t len, void *user_data);
+
+typedef struct {
+    size_t target_size;
+    uint64_t seed;
+    /* Per-mille probabilities of each mutation. */
+    int entity_rate;
+    int long_attr_rate;
+    int nest_rate;
+    size_t long_attr_max;
+} corpus_options_t;
+
+void corpus_options_init(corpus_options_t *options);
+
+/*
+ * Scales a search-results page up to roughly options->target_size bytes by
+ * repeating its article cards with randomized entities, long attributes and
+ * extra nesting. The page prefix and suffix are emitted once.
+ */
+int corpus_generate(const char *fixture, size_t fixture_len, const corpus_options_t *options,
+                    corpus_write_fn write, void *user_data);
+
+bool corpus_parse_size(const char *text, size_t *out);
+
+#endif
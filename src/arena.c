@@ -0,0 +1,95 @@
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+static size_t header_size(void) {
+    return (sizeof(arena_block_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static char *block_data(arena_block_t *block) {
+    return (char *)block + header_size();
+}
+
+void arena_init(arena_t *arena, size_t block_size) {
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size ? block_size : 4096;
+}
+
+void arena_free(arena_t *arena) {
+    arena_block_t *block = arena->head;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+void arena_reset(arena_t *arena) {
+    for (arena_block_t *block = arena->head; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = arena->head;
+}
+
+/* Inserts a block after the current one, so blocks kept from before a
+ * reset are still used in order. */
+static arena_block_t *add_block(arena_t *arena, size_t min_size) {
+    size_t size = arena->block_size > min_size ? arena->block_size : min_size;
+    arena_block_t *block = (arena_block_t *)malloc(header_size() + size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    block->used = 0;
+    if (arena->current) {
+        block->next = arena->current->next;
+        arena->current->next = block;
+    } else {
+        block->next = arena->head;
+        arena->head = block;
+    }
+    arena->current = block;
+    return block;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    arena_block_t *block = arena->current;
+    if (!block || block->size - block->used < size) {
+        arena_block_t *next = block ? block->next : NULL;
+        if (next && next->size >= size) {
+            block = next;
+            arena->current = next;
+        } else {
+            block = add_block(arena, size);
+            if (!block) {
+                return NULL;
+            }
+        }
+    }
+    void *p = block_data(block) + block->used;
+    block->used += size;
+    return p;
+}
+
+arena_str_t arena_strndup(arena_t *arena, const char *data, size_t len) {
+    arena_str_t str = {"", 0};
+    char *copy = (char *)arena_alloc(arena, len + 1);
+    if (!copy) {
+        return str;
+    }
+    if (len > 0) {
+        memcpy(copy, data, len);
+    }
+    copy[len] = '\0';
+    str.data = copy;
+    str.len = len;
+    return str;
+}
@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Bump allocator for data that dies together, e.g. the articles of one page.
+ * arena_reset() releases everything at once and keeps the blocks for reuse.
+ */
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+} arena_block_t;
+
+typedef struct {
+    arena_block_t *head;
+    arena_block_t *current;
+    size_t block_size;
+} arena_t;
+
+/* A length-tracked string. `data` is also NUL-terminated. */
+typedef struct {
+    const char *data;
+    size_t len;
+} arena_str_t;
+
+void arena_init(arena_t *arena, size_t block_size);
+void arena_free(arena_t *arena);
+void arena_reset(arena_t *arena);
+/* Returns NULL when out of memory. Allocations are aligned for any scalar. */
+void *arena_alloc(arena_t *arena, size_t size);
+/* Copies `len` bytes plus a NUL; on failure the result is the empty string. */
+arena_str_t arena_strndup(arena_t *arena, const char *data, size_t len);
+
+#endif
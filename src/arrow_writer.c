@@ -0,0 +1,380 @@
+#include "writer.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+/*
+ * Arrow IPC file format: every column is a non-null Utf8 array, and every
+ * batch becomes one or more record batches. The metadata is FlatBuffers,
+ * built here by hand front to back: a table's vtable comes right before it
+ * and the objects it refers to come after it, so offsets are patched in once
+ * their target has been appended.
+ */
+
+#define COLUMN_COUNT 5
+#define METADATA_V5 4
+#define HEADER_SCHEMA 1
+#define HEADER_RECORD_BATCH 3
+#define TYPE_UTF8 5
+
+static const char *const column_names[COLUMN_COUNT] = {"title", "url", "date", "author", "tags"};
+static const uint8_t zeros[8];
+
+typedef struct {
+    utils_sb_t buf;
+    bool failed;
+} fb_t;
+
+typedef struct {
+    int64_t offset;
+    int32_t metadata_length;
+    int64_t body_length;
+} arrow_block_t;
+
+typedef struct {
+    fb_t fb;
+    arrow_block_t *blocks;
+    size_t block_count;
+    size_t block_cap;
+} arrow_state_t;
+
+static arena_str_t column_of(const article_t *article, size_t column) {
+    switch (column) {
+        case 0:
+            return article->title;
+        case 1:
+            return article->url;
+        case 2:
+            return article->date;
+        case 3:
+            return article->author;
+        default:
+            return article->tags;
+    }
+}
+
+static size_t pad8(size_t len) {
+    return (len + 7) & ~(size_t)7;
+}
+
+static void store_le(uint8_t *dst, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/* Appends `size` zero bytes at a multiple of `align`; returns their position. */
+static size_t fb_alloc(fb_t *fb, size_t align, size_t size) {
+    size_t pad = (align - fb->buf.len % align) % align;
+    if (fb->failed || !utils_sb_reserve(&fb->buf, pad + size)) {
+        fb->failed = true;
+        return 0;
+    }
+    memset(fb->buf.data + fb->buf.len, 0, pad + size);
+    fb->buf.len += pad + size;
+    fb->buf.data[fb->buf.len] = '\0';
+    return fb->buf.len - size;
+}
+
+static void fb_put(fb_t *fb, size_t pos, uint64_t value, size_t size) {
+    if (!fb->failed) {
+        store_le((uint8_t *)fb->buf.data + pos, value, size);
+    }
+}
+
+/* Points the offset field at `slot` to the object at `target`. */
+static void fb_link(fb_t *fb, size_t slot, size_t target) {
+    fb_put(fb, slot, target - slot, 4);
+}
+
+/* Appends a vtable and its table. `sizes` lists the field sizes by field id,
+ * 0 for absent fields; the position of each field is stored in `slots`. */
+static size_t fb_table(fb_t *fb, const uint8_t *sizes, size_t count, size_t *slots) {
+    size_t vtable = fb_alloc(fb, 2, 4 + 2 * count);
+    size_t table_size = 4;
+    for (size_t i = 0; i < count; ++i) {
+        slots[i] = 0;
+        if (sizes[i] > 0) {
+            table_size = (table_size + sizes[i] - 1) / sizes[i] * sizes[i];
+            slots[i] = table_size;
+            table_size += sizes[i];
+        }
+    }
+    size_t table = fb_alloc(fb, 8, table_size);
+    fb_put(fb, vtable, 4 + 2 * count, 2);
+    fb_put(fb, vtable + 2, table_size, 2);
+    for (size_t i = 0; i < count; ++i) {
+        fb_put(fb, vtable + 4 + 2 * i, slots[i], 2);
+        slots[i] += table;
+    }
+    fb_put(fb, table, table - vtable, 4);
+    return table;
+}
+
+/* Appends a vector of `count` elements of `size` bytes, aligned to `align`.
+ * Returns the position of the first element; the vector itself starts at
+ * its length, four bytes earlier. */
+static size_t fb_vector(fb_t *fb, size_t count, size_t size, size_t align) {
+    fb_alloc(fb, 4, 0);
+    if ((fb->buf.len + 4) % align != 0) {
+        fb_alloc(fb, 4, 4);
+    }
+    size_t vector = fb_alloc(fb, 4, 4 + count * size);
+    fb_put(fb, vector, count, 4);
+    return vector + 4;
+}
+
+static size_t fb_string(fb_t *fb, const char *text) {
+    size_t len = strlen(text);
+    size_t string = fb_alloc(fb, 4, 4 + len + 1);
+    fb_put(fb, string, len, 4);
+    if (!fb->failed) {
+        memcpy(fb->buf.data + string + 4, text, len);
+    }
+    return string;
+}
+
+static size_t put_field(fb_t *fb, const char *name) {
+    /* name, nullable, type_type, type, dictionary, children */
+    static const uint8_t sizes[] = {4, 1, 1, 4, 0, 4};
+    size_t slots[6];
+    size_t field = fb_table(fb, sizes, 6, slots);
+    fb_put(fb, slots[2], TYPE_UTF8, 1);
+    fb_link(fb, slots[0], fb_string(fb, name));
+    fb_link(fb, slots[3], fb_table(fb, NULL, 0, NULL));
+    fb_link(fb, slots[5], fb_vector(fb, 0, 4, 4) - 4);
+    return field;
+}
+
+static size_t put_schema(fb_t *fb) {
+    /* endianness, fields */
+    static const uint8_t sizes[] = {2, 4};
+    size_t slots[2];
+    size_t schema = fb_table(fb, sizes, 2, slots);
+    size_t fields = fb_vector(fb, COLUMN_COUNT, 4, 4);
+    fb_link(fb, slots[1], fields - 4);
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        fb_link(fb, fields + 4 * c, put_field(fb, column_names[c]));
+    }
+    return schema;
+}
+
+/* Starts a Message in the emptied builder and returns the slot for its
+ * header. */
+static size_t put_message(fb_t *fb, uint8_t header_type, int64_t body_length) {
+    /* version, header_type, header, bodyLength */
+    static const uint8_t sizes[] = {2, 1, 4, 8};
+    size_t slots[4];
+    utils_sb_clear(&fb->buf);
+    size_t root = fb_alloc(fb, 4, 4);
+    size_t message = fb_table(fb, sizes, 4, slots);
+    fb_link(fb, root, message);
+    fb_put(fb, slots[0], METADATA_V5, 2);
+    fb_put(fb, slots[1], header_type, 1);
+    fb_put(fb, slots[3], (uint64_t)body_length, 8);
+    return slots[2];
+}
+
+/* Writes the message in the builder, padded to 8 bytes, and records it as a
+ * block when it is a record batch. */
+static void write_message(writer_t *writer, bool record_batch, int64_t body_length) {
+    arrow_state_t *state = writer->state;
+    if (state->fb.failed) {
+        writer->out.failed = true;
+        return;
+    }
+    size_t metadata_len = pad8(state->fb.buf.len);
+    if (record_batch) {
+        if (state->block_count == state->block_cap) {
+            size_t cap = state->block_cap ? state->block_cap * 2 : 16;
+            arrow_block_t *grown = realloc(state->blocks, cap * sizeof(*grown));
+            if (!grown) {
+                writer->out.failed = true;
+                return;
+            }
+            state->blocks = grown;
+            state->block_cap = cap;
+        }
+        arrow_block_t *block = &state->blocks[state->block_count++];
+        block->offset = (int64_t)writer->out.bytes_written;
+        block->metadata_length = (int32_t)(8 + metadata_len);
+        block->body_length = body_length;
+    }
+    uint8_t prefix[8];
+    store_le(prefix, 0xFFFFFFFFu, 4);
+    store_le(prefix + 4, metadata_len, 4);
+    output_write(&writer->out, prefix, sizeof(prefix));
+    output_write(&writer->out, state->fb.buf.data, state->fb.buf.len);
+    output_write(&writer->out, zeros, metadata_len - state->fb.buf.len);
+}
+
+static void write_offsets(writer_t *writer, const article_t *items, size_t rows, size_t column) {
+    uint8_t chunk[1024];
+    size_t used = 0;
+    uint32_t offset = 0;
+    for (size_t i = 0; i <= rows; ++i) {
+        if (used == sizeof(chunk)) {
+            output_write(&writer->out, chunk, used);
+            used = 0;
+        }
+        store_le(chunk + used, offset, 4);
+        used += 4;
+        if (i < rows) {
+            offset += (uint32_t)column_of(&items[i], column).len;
+        }
+    }
+    output_write(&writer->out, chunk, used);
+    output_write(&writer->out, zeros, pad8((rows + 1) * 4) - (rows + 1) * 4);
+}
+
+static void write_record_batch(writer_t *writer, const article_t *items, size_t rows, const size_t *data_len) {
+    arrow_state_t *state = writer->state;
+    fb_t *fb = &state->fb;
+    size_t offsets_len = pad8((rows + 1) * 4);
+    int64_t body_length = 0;
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        body_length += (int64_t)(offsets_len + pad8(data_len[c]));
+    }
+
+    /* length, nodes, buffers */
+    static const uint8_t sizes[] = {8, 4, 4};
+    size_t slots[3];
+    size_t header = put_message(fb, HEADER_RECORD_BATCH, body_length);
+    size_t batch = fb_table(fb, sizes, 3, slots);
+    fb_link(fb, header, batch);
+    fb_put(fb, slots[0], rows, 8);
+    size_t nodes = fb_vector(fb, COLUMN_COUNT, 16, 8);
+    fb_link(fb, slots[1], nodes - 4);
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        fb_put(fb, nodes + 16 * c, rows, 8);
+    }
+    /* Validity, offsets and data per column; no validity bitmap is needed
+     * as nothing is null. */
+    size_t buffers = fb_vector(fb, 3 * COLUMN_COUNT, 16, 8);
+    fb_link(fb, slots[2], buffers - 4);
+    size_t body_offset = 0;
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        size_t buffer = buffers + 48 * c;
+        fb_put(fb, buffer, body_offset, 8);
+        fb_put(fb, buffer + 16, body_offset, 8);
+        fb_put(fb, buffer + 24, (rows + 1) * 4, 8);
+        body_offset += offsets_len;
+        fb_put(fb, buffer + 32, body_offset, 8);
+        fb_put(fb, buffer + 40, data_len[c], 8);
+        body_offset += pad8(data_len[c]);
+    }
+    write_message(writer, true, body_length);
+
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        write_offsets(writer, items, rows, c);
+        for (size_t i = 0; i < rows; ++i) {
+            arena_str_t text = column_of(&items[i], c);
+            output_write(&writer->out, text.data, text.len);
+        }
+        output_write(&writer->out, zeros, pad8(data_len[c]) - data_len[c]);
+    }
+}
+
+static bool arrow_init(writer_t *writer) {
+    arrow_state_t *state = calloc(1, sizeof(*state));
+    if (!state) {
+        return false;
+    }
+    utils_sb_init(&state->fb.buf);
+    writer->state = state;
+    return true;
+}
+
+static void arrow_begin(writer_t *writer) {
+    arrow_state_t *state = writer->state;
+    static const char magic[8] = "ARROW1";
+    output_write(&writer->out, magic, sizeof(magic));
+    size_t header = put_message(&state->fb, HEADER_SCHEMA, 0);
+    fb_link(&state->fb, header, put_schema(&state->fb));
+    write_message(writer, false, 0);
+}
+
+/* Value offsets are int32, so a batch is split wherever a column would
+ * outgrow them. */
+static void arrow_write_batch(writer_t *writer, const article_batch_t *batch) {
+    size_t start = 0;
+    while (start < batch->len) {
+        size_t data_len[COLUMN_COUNT] = {0};
+        size_t end = start;
+        for (; end < batch->len; ++end) {
+            bool fits = true;
+            for (size_t c = 0; c < COLUMN_COUNT && fits; ++c) {
+                fits = column_of(&batch->items[end], c).len <= (size_t)INT32_MAX - data_len[c];
+            }
+            if (!fits) {
+                break;
+            }
+            for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+                data_len[c] += column_of(&batch->items[end], c).len;
+            }
+        }
+        if (end == start) {
+            fprintf(stderr, "Article too large for Arrow output, skipped\n");
+            writer->out.failed = true;
+            ++start;
+            continue;
+        }
+        write_record_batch(writer, batch->items + start, end - start, data_len);
+        start = end;
+    }
+}
+
+static void arrow_end(writer_t *writer) {
+    arrow_state_t *state = writer->state;
+    fb_t *fb = &state->fb;
+    uint8_t end_of_stream[8];
+    store_le(end_of_stream, 0xFFFFFFFFu, 4);
+    store_le(end_of_stream + 4, 0, 4);
+    output_write(&writer->out, end_of_stream, sizeof(end_of_stream));
+
+    /* version, schema, dictionaries, recordBatches */
+    static const uint8_t sizes[] = {2, 4, 4, 4};
+    size_t slots[4];
+    utils_sb_clear(&fb->buf);
+    size_t root = fb_alloc(fb, 4, 4);
+    size_t footer = fb_table(fb, sizes, 4, slots);
+    fb_link(fb, root, footer);
+    fb_put(fb, slots[0], METADATA_V5, 2);
+    fb_link(fb, slots[1], put_schema(fb));
+    fb_link(fb, slots[2], fb_vector(fb, 0, 24, 8) - 4);
+    size_t blocks = fb_vector(fb, state->block_count, 24, 8);
+    fb_link(fb, slots[3], blocks - 4);
+    for (size_t i = 0; i < state->block_count; ++i) {
+        const arrow_block_t *block = &state->blocks[i];
+        fb_put(fb, blocks + 24 * i, (uint64_t)block->offset, 8);
+        fb_put(fb, blocks + 24 * i + 8, (uint32_t)block->metadata_length, 4);
+        fb_put(fb, blocks + 24 * i + 16, (uint64_t)block->body_length, 8);
+    }
+    if (fb->failed) {
+        writer->out.failed = true;
+        return;
+    }
+    uint8_t trailer[10];
+    store_le(trailer, fb->buf.len, 4);
+    memcpy(trailer + 4, "ARROW1", 6);
+    output_write(&writer->out, fb->buf.data, fb->buf.len);
+    output_write(&writer->out, trailer, sizeof(trailer));
+}
+
+static void arrow_free(writer_t *writer) {
+    arrow_state_t *state = writer->state;
+    if (!state) {
+        return;
+    }
+    utils_sb_free(&state->fb.buf);
+    free(state->blocks);
+    free(state);
+    writer->state = NULL;
+}
+
+const writer_ops_t writer_arrow_ops = {
+    "arrow", arrow_init, arrow_begin, arrow_write_batch, arrow_end, arrow_free
+};
@@ -0,0 +1,45 @@
+#include "article.h"
+
+#include <stdlib.h>
+
+#define ARTICLE_ARENA_BLOCK (64 * 1024)
+
+void article_batch_init(article_batch_t *batch) {
+    batch->items = NULL;
+    batch->len = 0;
+    batch->cap = 0;
+    arena_init(&batch->arena, ARTICLE_ARENA_BLOCK);
+}
+
+void article_batch_free(article_batch_t *batch) {
+    free(batch->items);
+    batch->items = NULL;
+    batch->len = 0;
+    batch->cap = 0;
+    arena_free(&batch->arena);
+}
+
+void article_batch_clear(article_batch_t *batch) {
+    batch->len = 0;
+    arena_reset(&batch->arena);
+}
+
+article_t *article_batch_push(article_batch_t *batch) {
+    if (batch->len == batch->cap) {
+        size_t cap = batch->cap ? batch->cap * 2 : 32;
+        article_t *grown = (article_t *)realloc(batch->items, cap * sizeof(article_t));
+        if (!grown) {
+            return NULL;
+        }
+        batch->items = grown;
+        batch->cap = cap;
+    }
+    article_t *article = &batch->items[batch->len++];
+    arena_str_t empty = {"", 0};
+    article->title = empty;
+    article->url = empty;
+    article->date = empty;
+    article->author = empty;
+    article->tags = empty;
+    return article;
+}
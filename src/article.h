@@ -0,0 +1,34 @@
+#ifndef ARTICLE_H
+#define ARTICLE_H
+
+#include <stddef.h>
+
+#include "arena.h"
+
+typedef struct article {
+    arena_str_t title;
+    arena_str_t url;
+    arena_str_t date;
+    arena_str_t author;
+    arena_str_t tags;
+} article_t;
+
+/*
+ * Finished articles, typically those of one page. Their strings live in
+ * `arena`, so clearing the batch releases them in bulk and a consumer can
+ * hold on to the batch instead of copying the records.
+ */
+typedef struct {
+    article_t *items;
+    size_t len;
+    size_t cap;
+    arena_t arena;
+} article_batch_t;
+
+void article_batch_init(article_batch_t *batch);
+void article_batch_free(article_batch_t *batch);
+void article_batch_clear(article_batch_t *batch);
+/* Appends an article with empty fields; NULL when out of memory. */
+article_t *article_batch_push(article_batch_t *batch);
+
+#endif
@@ -0,0 +1,202 @@
+#include "compress.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HABR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HABR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define COMPRESS_CHUNK (256 * 1024)
+
+struct compress {
+    compress_kind_t kind;
+    unsigned char *out;
+    bool ready;
+#ifdef HABR_HAVE_ZLIB
+    z_stream gzip;
+#endif
+#ifdef HABR_HAVE_ZSTD
+    ZSTD_CCtx *zstd;
+#endif
+};
+
+bool compress_parse(const char *spec, compress_options_t *options) {
+    const char *colon = strchr(spec, ':');
+    size_t name_len = colon ? (size_t)(colon - spec) : strlen(spec);
+    long max_level;
+    if (name_len == 4 && strncmp(spec, "gzip", 4) == 0) {
+        options->kind = COMPRESS_GZIP;
+        options->level = 6;
+        max_level = 9;
+    } else if (name_len == 4 && strncmp(spec, "zstd", 4) == 0) {
+        options->kind = COMPRESS_ZSTD;
+        options->level = 3;
+        max_level = 22;
+    } else {
+        return false;
+    }
+    options->threads = 0;
+    if (colon) {
+        char *end = NULL;
+        long level = strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || level < 1 || level > max_level) {
+            return false;
+        }
+        options->level = (int)level;
+    }
+    return true;
+}
+
+bool compress_available(compress_kind_t kind) {
+#ifdef HABR_HAVE_ZLIB
+    if (kind == COMPRESS_GZIP) {
+        return true;
+    }
+#endif
+#ifdef HABR_HAVE_ZSTD
+    if (kind == COMPRESS_ZSTD) {
+        return true;
+    }
+#endif
+    return kind == COMPRESS_NONE;
+}
+
+compress_t *compress_new(const compress_options_t *options) {
+    const char *name = options->kind == COMPRESS_GZIP ? "gzip" : "zstd";
+    if (options->kind == COMPRESS_NONE || !compress_available(options->kind)) {
+        fprintf(stderr, "%s compression is not available in this build\n", name);
+        return NULL;
+    }
+    compress_t *compress = (compress_t *)calloc(1, sizeof(*compress));
+    if (!compress) {
+        return NULL;
+    }
+    compress->kind = options->kind;
+    compress->out = (unsigned char *)malloc(COMPRESS_CHUNK);
+#ifdef HABR_HAVE_ZLIB
+    if (compress->out && options->kind == COMPRESS_GZIP) {
+        /* Window bits above 15 select the gzip wrapper. */
+        compress->ready =
+            deflateInit2(&compress->gzip, options->level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+#endif
+#ifdef HABR_HAVE_ZSTD
+    if (compress->out && options->kind == COMPRESS_ZSTD) {
+        compress->zstd = ZSTD_createCCtx();
+        compress->ready =
+            compress->zstd && !ZSTD_isError(ZSTD_CCtx_setParameter(compress->zstd, ZSTD_c_compressionLevel, options->level));
+        if (compress->ready && options->threads > 0 &&
+            ZSTD_isError(ZSTD_CCtx_setParameter(compress->zstd, ZSTD_c_nbWorkers, options->threads))) {
+            fprintf(stderr, "libzstd was built without thread support\n");
+            compress->ready = false;
+        }
+    }
+#endif
+    if (!compress->ready) {
+        fprintf(stderr, "Failed to set up %s compression\n", name);
+        compress_free(compress);
+        return NULL;
+    }
+    return compress;
+}
+
+void compress_free(compress_t *compress) {
+    if (!compress) {
+        return;
+    }
+#ifdef HABR_HAVE_ZLIB
+    if (compress->kind == COMPRESS_GZIP && compress->ready) {
+        deflateEnd(&compress->gzip);
+    }
+#endif
+#ifdef HABR_HAVE_ZSTD
+    ZSTD_freeCCtx(compress->zstd);
+#endif
+    free(compress->out);
+    free(compress);
+}
+
+#ifdef HABR_HAVE_ZLIB
+static bool gzip_write(compress_t *compress, const unsigned char *data, size_t len, bool finish,
+                       compress_sink_fn sink, void *user_data) {
+    z_stream *stream = &compress->gzip;
+    for (;;) {
+        /* avail_in is narrower than size_t. */
+        size_t chunk = len > UINT_MAX ? UINT_MAX : len;
+        bool last = chunk == len;
+        int flush = last && finish ? Z_FINISH : Z_NO_FLUSH;
+        stream->next_in = (Bytef *)data;
+        stream->avail_in = (uInt)chunk;
+        int rc;
+        do {
+            stream->next_out = compress->out;
+            stream->avail_out = COMPRESS_CHUNK;
+            rc = deflate(stream, flush);
+            if (rc == Z_STREAM_ERROR) {
+                fprintf(stderr, "gzip compression failed\n");
+                return false;
+            }
+            size_t produced = COMPRESS_CHUNK - stream->avail_out;
+            if (produced > 0 && !sink(compress->out, produced, user_data)) {
+                return false;
+            }
+        } while (stream->avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+        if (last) {
+            break;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    if (finish) {
+        deflateReset(stream);
+    }
+    return true;
+}
+#endif
+
+#ifdef HABR_HAVE_ZSTD
+static bool zstd_write(compress_t *compress, const unsigned char *data, size_t len, bool finish,
+                       compress_sink_fn sink, void *user_data) {
+    ZSTD_inBuffer in = {data, len, 0};
+    for (;;) {
+        ZSTD_outBuffer out = {compress->out, COMPRESS_CHUNK, 0};
+        size_t remaining = ZSTD_compressStream2(compress->zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining)) {
+            fprintf(stderr, "zstd compression failed: %s\n", ZSTD_getErrorName(remaining));
+            return false;
+        }
+        if (out.pos > 0 && !sink(compress->out, out.pos, user_data)) {
+            return false;
+        }
+        if (finish ? remaining == 0 : in.pos == in.size) {
+            return true;
+        }
+    }
+}
+#endif
+
+bool compress_write(compress_t *compress, const void *data, size_t len, bool finish, compress_sink_fn sink,
+                    void *user_data) {
+#ifdef HABR_HAVE_ZLIB
+    if (compress->kind == COMPRESS_GZIP) {
+        return gzip_write(compress, (const unsigned char *)data, len, finish, sink, user_data);
+    }
+#endif
+#ifdef HABR_HAVE_ZSTD
+    if (compress->kind == COMPRESS_ZSTD) {
+        return zstd_write(compress, (const unsigned char *)data, len, finish, sink, user_data);
+    }
+#endif
+    (void)data;
+    (void)len;
+    (void)finish;
+    (void)sink;
+    (void)user_data;
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    COMPRESS_NONE,
+    COMPRESS_GZIP,
+    COMPRESS_ZSTD
+} compress_kind_t;
+
+typedef struct {
+    compress_kind_t kind;
+    int level;
+    /* zstd only: worker threads compressing blocks in parallel; 0 compresses
+     * on the calling thread. */
+    int threads;
+} compress_options_t;
+
+/* Parses "gzip" or "zstd", optionally followed by ":level". */
+bool compress_parse(const char *spec, compress_options_t *options);
+/* gzip needs zlib and zstd needs libzstd at build time. */
+bool compress_available(compress_kind_t kind);
+
+/* Receives compressed bytes in order; returns false to stop. */
+typedef bool (*compress_sink_fn)(const void *data, size_t len, void *user_data);
+
+/*
+ * Streaming compressor producing a standard .gz or .zst stream. Finishing
+ * ends the current gzip member or zstd frame; the next write starts a new
+ * one, and decompressors read the concatenation as one stream.
+ */
+typedef struct compress compress_t;
+
+/* NULL when unavailable or out of memory, with a message on stderr. */
+compress_t *compress_new(const compress_options_t *options);
+void compress_free(compress_t *compress);
+/* Returns false if compression or the sink failed. */
+bool compress_write(compress_t *compress, const void *data, size_t len, bool finish, compress_sink_fn sink,
+                    void *user_data);
+
+#endif
@@ -1,44 +1,66 @@
-#include "csv_writer.h"
+#include "writer.h"
 
-#include "extractor.h"
+#include <string.h>
 
-static void csv_escape_and_print(FILE *out, const char *text) {
-    fputc('"', out);
-    for (const char *p = text; *p; ++p) {
-        if (*p == '"') {
-            fputc('"', out);
-            fputc('"', out);
-        } else {
-            fputc(*p, out);
+#include "simd_scan.h"
+
+/* Fields are always quoted, so only '"' needs escaping; clean runs between
+ * quotes are found with the SIMD search kernel and copied whole. */
+static void put_field(output_t *out, arena_str_t text, char separator) {
+    const simd_kernels_t *kernels = simd_scan_kernels();
+    const char *p = text.data;
+    const char *end = text.data + text.len;
+    char *dst = output_reserve(out, 2 * text.len + 3);
+    if (!dst) {
+        output_write(out, "\"", 1);
+        while (p < end) {
+            const char *quote = kernels->find1(p, end, '"');
+            output_write(out, p, (size_t)(quote - p));
+            if (quote == end) {
+                break;
+            }
+            output_write(out, "\"\"", 2);
+            p = quote + 1;
         }
+        char tail[2] = {'"', separator};
+        output_write(out, tail, sizeof(tail));
+        return;
     }
-    fputc('"', out);
-}
-
-void csv_writer_init(csv_writer_t *writer, FILE *out) {
-    writer->out = out;
+    /* The escaped field fits as is, so skip the per-run capacity checks. */
+    char *start = dst;
+    *dst++ = '"';
+    while (p < end) {
+        const char *quote = kernels->find1(p, end, '"');
+        memcpy(dst, p, (size_t)(quote - p));
+        dst += quote - p;
+        if (quote == end) {
+            break;
+        }
+        *dst++ = '"';
+        *dst++ = '"';
+        p = quote + 1;
+    }
+    *dst++ = '"';
+    *dst++ = separator;
+    output_commit(out, (size_t)(dst - start));
 }
 
-void csv_writer_write_header(csv_writer_t *writer) {
-    if (!writer || !writer->out) {
-        return;
-    }
-    fprintf(writer->out, "title,url,date,author,tags\n");
+static void csv_begin(writer_t *writer) {
+    static const char header[] = "title,url,date,author,tags\n";
+    output_write(&writer->out, header, sizeof(header) - 1);
 }
 
-void csv_writer_write(csv_writer_t *writer, const struct article *article) {
-    if (!writer || !writer->out || !article) {
-        return;
+static void csv_write_batch(writer_t *writer, const article_batch_t *batch) {
+    for (size_t i = 0; i < batch->len; ++i) {
+        const article_t *article = &batch->items[i];
+        put_field(&writer->out, article->title, ',');
+        put_field(&writer->out, article->url, ',');
+        put_field(&writer->out, article->date, ',');
+        put_field(&writer->out, article->author, ',');
+        put_field(&writer->out, article->tags, '\n');
     }
-    csv_escape_and_print(writer->out, article->title);
-    fputc(',', writer->out);
-    csv_escape_and_print(writer->out, article->url);
-    fputc(',', writer->out);
-    csv_escape_and_print(writer->out, article->date);
-    fputc(',', writer->out);
-    csv_escape_and_print(writer->out, article->author);
-    fputc(',', writer->out);
-    csv_escape_and_print(writer->out, article->tags);
-    fputc('\n', writer->out);
 }
 
+const writer_ops_t writer_csv_ops = {
+    "csv", NULL, csv_begin, csv_write_batch, NULL, NULL
+};
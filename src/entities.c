@@ -1,82 +1,158 @@
 #include "entities.h"
 
-#include <ctype.h>
-#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
-static int decode_numeric(const char *entity) {
-    if (entity[1] == 'x' || entity[1] == 'X') {
-        return (int)strtol(entity + 2, NULL, 16);
+/* Code points for numeric references to 0x80..0x9F; zero keeps the value. */
+static const uint16_t c1_remap[32] = {
+    0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017D, 0,
+    0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178,
+};
+
+static bool is_alnum(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+static int digit_value(char c, bool hex) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (hex && c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (hex && c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
     }
-    return (int)strtol(entity + 1, NULL, 10);
+    return -1;
 }
 
-void entities_decode_inplace(char *str) {
-    if (!str) {
-        return;
+static size_t encode_utf8(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
     }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static size_t match_numeric(const char *src, size_t len, char *value, size_t *value_len) {
+    size_t i = 2;
+    bool hex = i < len && (src[i] == 'x' || src[i] == 'X');
+    if (hex) {
+        ++i;
+    }
+    size_t digits = i;
+    uint32_t cp = 0;
+    for (; i < len; ++i) {
+        int d = digit_value(src[i], hex);
+        if (d < 0) {
+            break;
+        }
+        if (cp <= 0x10FFFF) {
+            cp = cp * (hex ? 16 : 10) + (uint32_t)d;
+        }
+    }
+    if (i == digits) {
+        return 0;
+    }
+    if (i < len && src[i] == ';') {
+        ++i;
+    }
+    if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = 0xFFFD;
+    } else if (cp >= 0x80 && cp <= 0x9F && c1_remap[cp - 0x80] != 0) {
+        cp = c1_remap[cp - 0x80];
+    }
+    *value_len = encode_utf8(cp, value);
+    return i;
+}
+
+static size_t match_named(const char *src, size_t len, char *value, size_t *value_len) {
+    size_t end = 1;
+    while (end < len && end <= ENTITIES_NAME_MAX && is_alnum(src[end])) {
+        ++end;
+    }
+    size_t name_len = end - 1;
+    if (name_len == 0) {
+        return 0;
+    }
+    const char *found = NULL;
+    size_t found_len = 0;
+    if (end < len && src[end] == ';' && entities_table_lookup(src + 1, name_len + 1, &found, &found_len)) {
+        memcpy(value, found, found_len);
+        *value_len = found_len;
+        return end + 1;
+    }
+    if ((end == len || (!is_alnum(src[end]) && src[end] != '=')) &&
+        entities_table_lookup(src + 1, name_len, &found, &found_len)) {
+        memcpy(value, found, found_len);
+        *value_len = found_len;
+        return end;
+    }
+    return 0;
+}
+
+size_t entities_match(const char *src, size_t len, char value[ENTITIES_VALUE_MAX], size_t *value_len) {
+    if (len < 2) {
+        return 0;
+    }
+    if (src[1] == '#') {
+        return match_numeric(src, len, value, value_len);
+    }
+    return match_named(src, len, value, value_len);
+}
+
+size_t entities_decode(char *str, size_t len) {
     char *dst = str;
-    for (char *src = str; *src; ) {
-        if (*src == '&') {
-            char *semi = strchr(src, ';');
-            if (!semi || (semi - src) > 10) {
-                *dst++ = *src++;
-                continue;
-            }
-            size_t len = (size_t)(semi - src - 1);
-            if (len == 0) {
-                *dst++ = *src++;
-                continue;
-            }
-            if (strncmp(src, "&amp;", 5) == 0) {
-                *dst++ = '&';
-                src = semi + 1;
-                continue;
-            }
-            if (strncmp(src, "&lt;", 4) == 0) {
-                *dst++ = '<';
-                src = semi + 1;
-                continue;
-            }
-            if (strncmp(src, "&gt;", 4) == 0) {
-                *dst++ = '>';
-                src = semi + 1;
-                continue;
-            }
-            if (strncmp(src, "&nbsp;", 6) == 0) {
-                *dst++ = ' ';
-                src = semi + 1;
-                continue;
-            }
-            if (src[1] == '#') {
-                int value = decode_numeric(src + 1);
-                if (value <= 0) {
-                    src = semi + 1;
-                    continue;
-                }
-                if (value < 0x80) {
-                    *dst++ = (char)value;
-                } else if (value < 0x800) {
-                    *dst++ = (char)(0xC0 | (value >> 6));
-                    *dst++ = (char)(0x80 | (value & 0x3F));
-                } else if (value < 0x10000) {
-                    *dst++ = (char)(0xE0 | (value >> 12));
-                    *dst++ = (char)(0x80 | ((value >> 6) & 0x3F));
-                    *dst++ = (char)(0x80 | (value & 0x3F));
-                } else {
-                    *dst++ = '?';
-                }
-                src = semi + 1;
-                continue;
-            }
-            /* Unknown entity: keep as-is */
-            while (src <= semi) {
-                *dst++ = *src++;
-            }
-        } else {
+    const char *src = str;
+    const char *end = str + len;
+    while (src < end) {
+        const char *amp = (const char *)memchr(src, '&', (size_t)(end - src));
+        if (!amp) {
+            amp = end;
+        }
+        if (dst != src) {
+            memmove(dst, src, (size_t)(amp - src));
+        }
+        dst += amp - src;
+        src = amp;
+        if (src == end) {
+            break;
+        }
+        char value[ENTITIES_VALUE_MAX];
+        size_t value_len = 0;
+        size_t used = entities_match(src, (size_t)(end - src), value, &value_len);
+        if (used == 0 || value_len > used + (size_t)(src - dst)) {
             *dst++ = *src++;
+            continue;
         }
+        memcpy(dst, value, value_len);
+        dst += value_len;
+        src += used;
     }
-    *dst = '\0';
+    return (size_t)(dst - str);
 }
 
+void entities_decode_inplace(char *str) {
+    if (!str) {
+        return;
+    }
+    str[entities_decode(str, strlen(str))] = '\0';
+}
@@ -1,6 +1,27 @@
 #ifndef ENTITIES_H
 #define ENTITIES_H
 
+#include <stddef.h>
+
+#include "entities_table.h"
+
+/* Decodes the `len` bytes at `str` in place and returns the new length. The
+ * result is not NUL-terminated. */
+size_t entities_decode(char *str, size_t len);
 void entities_decode_inplace(char *str);
 
+/*
+ * Matches a character reference at `src`, which starts with '&' and has
+ * `len` bytes available. Returns how many bytes it spans, or 0 when there is
+ * none; its UTF-8 replacement goes to `value`. Named references without a
+ * ';' (the legacy forms) only match when no letter, digit or '=' follows.
+ * Numeric references follow the HTML rules: out-of-range values and
+ * surrogates become U+FFFD, C1 controls are read as Windows-1252.
+ *
+ * Two references, "&nGt;" and "&nLt;", decode to more bytes than they span.
+ * Decoding in place, they are only replaced once earlier references have
+ * freed enough room; otherwise they are kept as they are.
+ */
+size_t entities_match(const char *src, size_t len, char value[ENTITIES_VALUE_MAX], size_t *value_len);
+
 #endif
@@ -0,0 +1,18 @@
+#ifndef ENTITIES_TABLE_H
+#define ENTITIES_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Longest name in the table, ';' included, and longest UTF-8 value. */
+#define ENTITIES_NAME_MAX 32
+#define ENTITIES_VALUE_MAX 8
+
+/*
+ * Named character references, generated at build time by
+ * tools/gen_entities.c from tools/html_entities.txt. `name` excludes the
+ * '&', e.g. "amp;" or the legacy form "amp".
+ */
+bool entities_table_lookup(const char *name, size_t len, const char **value, size_t *value_len);
+
+#endif
@@ -2,258 +2,338 @@
 
 #include <string.h>
 
-#include "entities.h"
+#include "text_norm.h"
 #include "utils.h"
 
+const char *const extractor_field_names[EXTRACTOR_FIELD_COUNT] = {
+    [EXTRACTOR_FIELD_TITLE] = "title",
+    [EXTRACTOR_FIELD_URL] = "url",
+    [EXTRACTOR_FIELD_DATE] = "date",
+    [EXTRACTOR_FIELD_AUTHOR] = "author",
+    [EXTRACTOR_FIELD_TAGS] = "tags",
+};
+
+const char extractor_habr_selectors[] =
+    "article.tm-articles-list__item -> record\n"
+    "article.tm-articles-list__item a.tm-title__link -> title, @href:url\n"
+    "article.tm-articles-list__item a.tm-user-info__username -> author\n"
+    "article.tm-articles-list__item time -> @datetime:date\n"
+    "article.tm-articles-list__item div.tm-publication-hubs a.tm-publication-hub__link -> tags\n";
+
 static void reset_current(extractor_t *ext) {
-    memset(&ext->current, 0, sizeof(ext->current));
-    ext->current_tag_text[0] = '\0';
-    ext->in_title_link = false;
-    ext->title_depth = 0;
-    ext->in_author_link = false;
-    ext->author_depth = 0;
-    ext->in_tag_link = false;
-    ext->tag_link_depth = 0;
-    ext->in_hubs = false;
-    ext->hubs_depth = 0;
+    for (size_t i = 0; i < EXTRACTOR_FIELD_COUNT; ++i) {
+        utils_sb_clear(&ext->fields[i]);
+    }
+    utils_sb_clear(&ext->tag_text);
 }
 
-void extractor_init(extractor_t *ext, csv_writer_t *writer, size_t limit) {
-    memset(ext, 0, sizeof(*ext));
-    ext->writer = writer;
-    ext->limit = limit;
+static void set_text(utils_sb_t *text, const char *value, size_t len) {
+    utils_sb_clear(text);
+    utils_sb_append(text, value, len);
 }
 
-size_t extractor_get_count(const extractor_t *ext) {
-    return ext->count;
+static void finalize_field(utils_sb_t *text, bool collapse_decoded) {
+    if (text->len == 0) {
+        return;
+    }
+    utils_sb_truncate(text, text_normalize(text->data, text->len, collapse_decoded));
 }
 
-bool extractor_is_done(const extractor_t *ext) {
-    return ext->done;
+static void finalize_tag_text(extractor_t *ext) {
+    finalize_field(&ext->tag_text, false);
+    if (ext->tag_text.len == 0) {
+        return;
+    }
+    utils_sb_t *tags = &ext->fields[EXTRACTOR_FIELD_TAGS];
+    if (tags->len > 0) {
+        utils_sb_append_char(tags, ';');
+    }
+    utils_sb_append(tags, ext->tag_text.data, ext->tag_text.len);
+    utils_sb_clear(&ext->tag_text);
 }
 
-static void finalize_field(char *buffer) {
-    utils_replace_newlines_with_space(buffer);
-    utils_normalize_whitespace(buffer);
-    entities_decode_inplace(buffer);
+static arena_str_t batch_string(extractor_t *ext, const utils_sb_t *text) {
+    return arena_strndup(&ext->batch.arena, text->data, text->len);
 }
 
-static void finalize_tag_text(extractor_t *ext) {
-    char temp[ARTICLE_TAG_TEXT_CAP];
-    utils_copy_string(temp, sizeof(temp), ext->current_tag_text);
-    utils_replace_newlines_with_space(temp);
-    utils_normalize_whitespace(temp);
-    entities_decode_inplace(temp);
-    if (temp[0] == '\0') {
+static void flush_batch(extractor_t *ext) {
+    if (ext->batch.len == 0) {
         return;
     }
-    if (ext->current.tags[0] != '\0') {
-        utils_safe_append_char(ext->current.tags, sizeof(ext->current.tags), ';');
+    if (ext->stats) {
+        ext->stats->articles_emitted += ext->batch.len;
+    }
+    if (ext->batch_sink) {
+        ext->batch_sink(ext->batch_sink_data, &ext->batch);
+    } else if (ext->writer) {
+        long long start = ext->stats ? utils_now_us() : 0;
+        writer_submit_batch(ext->writer, &ext->batch);
+        if (ext->stats) {
+            ext->stats->write_us += utils_now_us() - start;
+        }
     }
-    utils_safe_append(ext->current.tags, sizeof(ext->current.tags), temp);
-    ext->current_tag_text[0] = '\0';
+    article_batch_clear(&ext->batch);
 }
 
 static void finish_article(extractor_t *ext) {
-    if (ext->current.title[0] == '\0' || ext->current.url[0] == '\0') {
-        reset_current(ext);
-        ext->in_article = false;
-        ext->article_depth = 0;
+    ext->in_article = false;
+    finalize_field(&ext->fields[EXTRACTOR_FIELD_TITLE], true);
+    finalize_field(&ext->fields[EXTRACTOR_FIELD_AUTHOR], true);
+    if (ext->fields[EXTRACTOR_FIELD_TITLE].len == 0 || ext->fields[EXTRACTOR_FIELD_URL].len == 0) {
+        if (ext->stats) {
+            ext->stats->articles_incomplete++;
+        }
         return;
     }
-    finalize_field(ext->current.title);
-    finalize_field(ext->current.author);
-    if (ext->current.tags[0] != '\0') {
-        utils_replace_newlines_with_space(ext->current.tags);
-    }
-    if (ext->current.date[0] == '\0') {
-        ext->current.date[0] = '\0';
+    if (ext->fields[EXTRACTOR_FIELD_TAGS].len > 0) {
+        utils_replace_newlines_with_space(ext->fields[EXTRACTOR_FIELD_TAGS].data);
     }
-    if (ext->writer) {
-        csv_writer_write(ext->writer, &ext->current);
+    article_t *article = article_batch_push(&ext->batch);
+    if (!article) {
+        return;
     }
+    article->title = batch_string(ext, &ext->fields[EXTRACTOR_FIELD_TITLE]);
+    article->url = batch_string(ext, &ext->fields[EXTRACTOR_FIELD_URL]);
+    article->date = batch_string(ext, &ext->fields[EXTRACTOR_FIELD_DATE]);
+    article->author = batch_string(ext, &ext->fields[EXTRACTOR_FIELD_AUTHOR]);
+    article->tags = batch_string(ext, &ext->fields[EXTRACTOR_FIELD_TAGS]);
     ext->count++;
     if (ext->limit > 0 && ext->count >= ext->limit) {
         ext->done = true;
     }
+    if (!ext->in_document) {
+        flush_batch(ext);
+    }
+}
+
+static void on_record_begin(void *user_data) {
+    extractor_t *ext = (extractor_t *)user_data;
+    ext->in_article = true;
     reset_current(ext);
-    ext->in_article = false;
-    ext->article_depth = 0;
 }
 
-static void handle_text(extractor_t *ext, const token_t *token) {
-    if (!ext->in_article) {
-        return;
-    }
-    if (ext->in_title_link) {
-        utils_safe_append(ext->current.title, sizeof(ext->current.title), token->text);
-    }
-    if (ext->in_author_link) {
-        utils_safe_append(ext->current.author, sizeof(ext->current.author), token->text);
+static void on_record_end(void *user_data) {
+    finish_article((extractor_t *)user_data);
+}
+
+static void on_field_begin(void *user_data, int field) {
+    extractor_t *ext = (extractor_t *)user_data;
+    if (field == EXTRACTOR_FIELD_TAGS) {
+        utils_sb_clear(&ext->tag_text);
     }
-    if (ext->in_tag_link) {
-        utils_safe_append(ext->current_tag_text, sizeof(ext->current_tag_text), token->text);
+}
+
+/* Text of `field` collects here; tags collect one link at a time. */
+static utils_sb_t *field_text(extractor_t *ext, int field) {
+    return field == EXTRACTOR_FIELD_TAGS ? &ext->tag_text : &ext->fields[field];
+}
+
+static void on_field_text(void *user_data, int field, const char *text, size_t len) {
+    extractor_t *ext = (extractor_t *)user_data;
+    if (ext->in_article) {
+        utils_sb_append(field_text(ext, field), text, len);
     }
 }
 
-static void handle_start(extractor_t *ext, const token_t *token) {
-    if (ext->limit > 0 && ext->count >= ext->limit) {
-        ext->done = true;
-        return;
+static void on_field_end(void *user_data, int field) {
+    extractor_t *ext = (extractor_t *)user_data;
+    if (ext->in_article && field == EXTRACTOR_FIELD_TAGS) {
+        finalize_tag_text(ext);
     }
+}
+
+static void on_field_value(void *user_data, int field, const char *value, size_t len) {
+    extractor_t *ext = (extractor_t *)user_data;
     if (!ext->in_article) {
-        if (strcmp(token->tag, "article") == 0 && utils_class_contains(token->attrs, "tm-articles-list__item")) {
-            ext->in_article = true;
-            ext->article_depth = 1;
-            reset_current(ext);
-        }
         return;
     }
-    if (strcmp(token->tag, "article") == 0) {
-        ext->article_depth++;
-        return;
+    switch (field) {
+        case EXTRACTOR_FIELD_URL: {
+            utils_sb_t *url = &ext->fields[EXTRACTOR_FIELD_URL];
+            size_t needed = utils_make_absolute_url(value, len, NULL, 0);
+            utils_sb_clear(url);
+            if (utils_sb_reserve(url, needed)) {
+                url->len = utils_make_absolute_url(value, len, url->data, url->cap);
+            }
+            break;
+        }
+        case EXTRACTOR_FIELD_DATE:
+            if (len >= 10) {
+                set_text(&ext->fields[EXTRACTOR_FIELD_DATE], value, 10);
+            }
+            break;
+        case EXTRACTOR_FIELD_TAGS:
+            set_text(&ext->tag_text, value, len);
+            finalize_tag_text(ext);
+            break;
+        default:
+            set_text(&ext->fields[field], value, len);
+            break;
     }
+}
 
-    bool title_active_before = ext->in_title_link;
-    bool author_active_before = ext->in_author_link;
-    bool tag_active_before = ext->in_tag_link;
+static const selector_sink_t extractor_sink = {
+    on_record_begin,
+    on_record_end,
+    on_field_begin,
+    on_field_text,
+    on_field_end,
+    on_field_value,
+};
 
-    if (strcmp(token->tag, "div") == 0) {
-        if (!ext->in_hubs && utils_class_contains(token->attrs, "tm-publication-hubs")) {
-            ext->in_hubs = true;
-            ext->hubs_depth = 1;
-        } else if (ext->in_hubs) {
-            ext->hubs_depth++;
-        }
+bool extractor_init(extractor_t *ext, writer_t *writer, size_t limit) {
+    memset(ext, 0, sizeof(*ext));
+    ext->writer = writer;
+    ext->limit = limit;
+    if (!selector_compile(&ext->selector, extractor_habr_selectors, extractor_field_names, EXTRACTOR_FIELD_COUNT)) {
+        selector_free(&ext->selector);
+        return false;
     }
+    selector_matcher_init(&ext->matcher, &ext->selector, &extractor_sink, ext);
+    article_batch_init(&ext->batch);
+    return true;
+}
 
-    if (strcmp(token->tag, "a") == 0) {
-        if (utils_class_contains(token->attrs, "tm-title__link")) {
-            ext->in_title_link = true;
-            ext->title_depth = 1;
-            char href[ARTICLE_URL_CAP];
-            if (utils_parse_attr(token->attrs, "href", href, sizeof(href))) {
-                utils_make_absolute_url(href, ext->current.url, sizeof(ext->current.url));
-            }
-        }
-        if (utils_class_contains(token->attrs, "tm-user-info__username")) {
-            ext->in_author_link = true;
-            ext->author_depth = 1;
-        }
-        if (ext->in_hubs && utils_class_contains(token->attrs, "tm-publication-hub__link")) {
-            ext->in_tag_link = true;
-            ext->tag_link_depth = 1;
-            ext->current_tag_text[0] = '\0';
-        }
+void extractor_free(extractor_t *ext) {
+    if (ext->in_document) {
+        html_scanner_free(&ext->scanner);
+        ext->in_document = false;
     }
-
-    if (strcmp(token->tag, "time") == 0) {
-        char datetime[128];
-        if (utils_parse_attr(token->attrs, "datetime", datetime, sizeof(datetime))) {
-            if (strlen(datetime) >= 10) {
-                char temp[ARTICLE_DATE_CAP];
-                size_t copy_len = 10;
-                if (copy_len >= sizeof(temp)) {
-                    copy_len = sizeof(temp) - 1;
-                }
-                memcpy(temp, datetime, copy_len);
-                temp[copy_len] = '\0';
-                utils_copy_string(ext->current.date, sizeof(ext->current.date), temp);
-            }
-        }
+    selector_free(&ext->selector);
+    for (size_t i = 0; i < EXTRACTOR_FIELD_COUNT; ++i) {
+        utils_sb_free(&ext->fields[i]);
     }
+    utils_sb_free(&ext->tag_text);
+    article_batch_free(&ext->batch);
+}
 
-    if (title_active_before && ext->in_title_link) {
-        ext->title_depth++;
+bool extractor_set_selectors(extractor_t *ext, const char *spec) {
+    selector_t compiled;
+    if (!selector_compile(&compiled, spec, extractor_field_names, EXTRACTOR_FIELD_COUNT)) {
+        selector_free(&compiled);
+        return false;
     }
-    if (author_active_before && ext->in_author_link) {
-        ext->author_depth++;
-    }
-    if (tag_active_before && ext->in_tag_link) {
-        ext->tag_link_depth++;
+    selector_free(&ext->selector);
+    ext->selector = compiled;
+    selector_matcher_init(&ext->matcher, &ext->selector, &extractor_sink, ext);
+    return true;
+}
+
+void extractor_set_stats(extractor_t *ext, stats_t *stats) {
+    ext->stats = stats;
+}
+
+void extractor_set_batch_sink(extractor_t *ext, extractor_batch_fn sink, void *user_data) {
+    ext->batch_sink = sink;
+    ext->batch_sink_data = user_data;
+}
+
+size_t extractor_get_count(const extractor_t *ext) {
+    return ext->count;
+}
+
+bool extractor_is_done(const extractor_t *ext) {
+    return ext->done;
+}
+
+/* Outside a record nothing but the next record matters, so let the scanner
+ * fast-forward to it when the rules allow. Only applies to documents fed
+ * through the extractor. */
+static void seek_next_record(extractor_t *ext) {
+    if (ext->in_document && !ext->done && ext->selector.seek[0] != '\0') {
+        selector_matcher_reset(&ext->matcher);
+        html_scanner_skip_to(&ext->scanner, ext->selector.seek);
     }
 }
 
-static void handle_end(extractor_t *ext, const token_t *token) {
-    if (!ext->in_article) {
-        return;
+bool extractor_process_token(extractor_t *ext, const token_t *token) {
+    if (ext->done) {
+        return false;
     }
-    if (strcmp(token->tag, "article") == 0) {
-        if (ext->article_depth > 0) {
-            ext->article_depth--;
-        }
-        if (ext->article_depth == 0) {
-            finish_article(ext);
-        }
-        return;
+    if (token->type == TOKEN_START_TAG && ext->limit > 0 && ext->count >= ext->limit) {
+        ext->done = true;
+        return false;
     }
-
-    if (ext->in_title_link) {
-        if (ext->title_depth > 0) {
-            ext->title_depth--;
-        }
-        if (ext->title_depth == 0) {
-            ext->in_title_link = false;
-            finalize_field(ext->current.title);
-        }
+    selector_matcher_token(&ext->matcher, token);
+    if (!ext->in_article && token->type != TOKEN_TEXT) {
+        seek_next_record(ext);
     }
+    return !ext->done;
+}
 
-    if (ext->in_author_link) {
-        if (ext->author_depth > 0) {
-            ext->author_depth--;
-        }
-        if (ext->author_depth == 0) {
-            ext->in_author_link = false;
-            finalize_field(ext->current.author);
-        }
+static bool token_callback(const token_t *token, void *user_data) {
+    return extractor_process_token((extractor_t *)user_data, token);
+}
+
+static void flush_scanner_stats(extractor_t *ext) {
+    if (ext->stats) {
+        ext->stats->scan_bytes += ext->scanner.bytes_scanned;
+        ext->stats->scan_tokens += ext->scanner.tokens_emitted;
     }
+}
 
-    if (ext->in_tag_link) {
-        if (ext->tag_link_depth > 0) {
-            ext->tag_link_depth--;
-        }
-        if (ext->tag_link_depth == 0) {
-            ext->in_tag_link = false;
-            finalize_tag_text(ext);
-        }
+static void reset_document(extractor_t *ext) {
+    if (ext->in_document) {
+        flush_scanner_stats(ext);
+        html_scanner_free(&ext->scanner);
     }
+    html_scanner_init(&ext->scanner, token_callback, ext);
+    ext->in_document = true;
+    reset_current(ext);
+    ext->in_article = false;
+    selector_matcher_reset(&ext->matcher);
+    seek_next_record(ext);
+}
 
-    if (ext->in_hubs && strcmp(token->tag, "div") == 0) {
-        if (ext->hubs_depth > 0) {
-            ext->hubs_depth--;
-        }
-        if (ext->hubs_depth == 0) {
-            ext->in_hubs = false;
-        }
+void extractor_begin_document(extractor_t *ext) {
+    flush_batch(ext);
+    ext->doc_start_count = ext->count;
+    reset_document(ext);
+}
+
+/* Articles of the failed attempt were never written; drop them and count
+ * them again when they come back. */
+void extractor_restart_document(extractor_t *ext) {
+    if (ext->stats) {
+        ext->stats->articles_duplicate += ext->batch.len;
     }
+    article_batch_clear(&ext->batch);
+    ext->count = ext->doc_start_count;
+    ext->done = ext->limit > 0 && ext->count >= ext->limit;
+    reset_document(ext);
 }
 
-void extractor_process_token(extractor_t *ext, const token_t *token) {
-    if (ext->done) {
-        return;
+bool extractor_feed(extractor_t *ext, const char *data, size_t len) {
+    if (!ext->in_document) {
+        extractor_begin_document(ext);
     }
-    switch (token->type) {
-        case TOKEN_START_TAG:
-            handle_start(ext, token);
-            break;
-        case TOKEN_END_TAG:
-            handle_end(ext, token);
-            break;
-        case TOKEN_TEXT:
-            handle_text(ext, token);
-            break;
+    if (!ext->stats) {
+        return html_scanner_feed(&ext->scanner, data, len, false);
     }
+    long long start = utils_now_us();
+    bool more = html_scanner_feed(&ext->scanner, data, len, false);
+    ext->stats->parse_us += utils_now_us() - start;
+    return more;
 }
 
-static void token_callback(const token_t *token, void *user_data) {
-    extractor_t *ext = (extractor_t *)user_data;
-    extractor_process_token(ext, token);
+void extractor_end_document(extractor_t *ext) {
+    if (!ext->in_document) {
+        return;
+    }
+    long long start = ext->stats ? utils_now_us() : 0;
+    html_scanner_feed(&ext->scanner, "", 0, true);
+    html_scanner_finish(&ext->scanner);
+    if (ext->stats) {
+        ext->stats->parse_us += utils_now_us() - start;
+    }
+    flush_scanner_stats(ext);
+    html_scanner_free(&ext->scanner);
+    ext->in_document = false;
+    flush_batch(ext);
 }
 
 void extractor_consume_html(extractor_t *ext, const char *html, size_t len) {
-    html_scanner_t scanner;
-    html_scanner_init(&scanner, token_callback, ext);
-    html_scanner_feed(&scanner, html, len, true);
-    html_scanner_finish(&scanner);
+    extractor_begin_document(ext);
+    extractor_feed(ext, html, len);
+    extractor_end_document(ext);
 }
-
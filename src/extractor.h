@@ -5,51 +5,75 @@
 #include <stdbool.h>
 
 #include "html_scan.h"
-#include "csv_writer.h"
-
-#define ARTICLE_TITLE_CAP 1024
-#define ARTICLE_URL_CAP 1024
-#define ARTICLE_DATE_CAP 32
-#define ARTICLE_AUTHOR_CAP 256
-#define ARTICLE_TAGS_CAP 1024
-#define ARTICLE_TAG_TEXT_CAP 512
-
-typedef struct article {
-    char title[ARTICLE_TITLE_CAP];
-    char url[ARTICLE_URL_CAP];
-    char date[ARTICLE_DATE_CAP];
-    char author[ARTICLE_AUTHOR_CAP];
-    char tags[ARTICLE_TAGS_CAP];
-} article_t;
+#include "selector.h"
+#include "article.h"
+#include "writer.h"
+#include "stats.h"
+#include "utils.h"
+
+/* Fields selector rules can write to, named as in extractor_field_names. */
+typedef enum {
+    EXTRACTOR_FIELD_TITLE,
+    EXTRACTOR_FIELD_URL,
+    EXTRACTOR_FIELD_DATE,
+    EXTRACTOR_FIELD_AUTHOR,
+    EXTRACTOR_FIELD_TAGS,
+    EXTRACTOR_FIELD_COUNT
+} extractor_field_t;
+
+extern const char *const extractor_field_names[EXTRACTOR_FIELD_COUNT];
+/* Rules for Habr article lists; see selector.h for the syntax. */
+extern const char extractor_habr_selectors[];
+
+/* Receives finished batches in place of the writer. It may keep the articles
+ * by swapping `batch` with an empty one. */
+typedef void (*extractor_batch_fn)(void *user_data, article_batch_t *batch);
 
 typedef struct {
-    csv_writer_t *writer;
+    writer_t *writer;
+    extractor_batch_fn batch_sink;
+    void *batch_sink_data;
     size_t limit;
     size_t count;
     bool done;
 
+    selector_t selector;
+    selector_matcher_t matcher;
     bool in_article;
-    int article_depth;
-
-    bool in_title_link;
-    int title_depth;
 
-    bool in_author_link;
-    int author_depth;
+    /* Fields of the article being read. Text of the tag link being read
+     * goes to `tag_text` and is appended to the tags when the link closes. */
+    utils_sb_t fields[EXTRACTOR_FIELD_COUNT];
+    utils_sb_t tag_text;
 
-    bool in_hubs;
-    int hubs_depth;
+    /* Finished articles of the current document. They reach the writer in
+     * one batch when the document ends, so a restarted document simply
+     * drops them. Outside a document each article is written at once. */
+    article_batch_t batch;
+    size_t doc_start_count;
 
-    bool in_tag_link;
-    int tag_link_depth;
+    /* Streaming state for the document being fed. */
+    html_scanner_t scanner;
+    bool in_document;
 
-    article_t current;
-    char current_tag_text[ARTICLE_TAG_TEXT_CAP];
+    stats_t *stats;
 } extractor_t;
 
-void extractor_init(extractor_t *ext, csv_writer_t *writer, size_t limit);
+/* Starts with extractor_habr_selectors. Returns false only when out of memory. */
+bool extractor_init(extractor_t *ext, writer_t *writer, size_t limit);
+void extractor_free(extractor_t *ext);
+/* Replaces the rules; on a syntax error the previous ones stay in place. */
+bool extractor_set_selectors(extractor_t *ext, const char *spec);
+void extractor_set_stats(extractor_t *ext, stats_t *stats);
+void extractor_set_batch_sink(extractor_t *ext, extractor_batch_fn sink, void *user_data);
 void extractor_consume_html(extractor_t *ext, const char *html, size_t len);
-void extractor_process_token(extractor_t *ext, const token_t *token);
+void extractor_begin_document(extractor_t *ext);
+void extractor_restart_document(extractor_t *ext);
+/* Returns false once the article limit is reached and the rest of the
+ * document is not needed. */
+bool extractor_feed(extractor_t *ext, const char *data, size_t len);
+void extractor_end_document(extractor_t *ext);
+bool extractor_process_token(extractor_t *ext, const token_t *token);
 size_t extractor_get_count(const extractor_t *ext);
 bool extractor_is_done(const extractor_t *ext);
 
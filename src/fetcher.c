@@ -0,0 +1,310 @@
+#include "fetcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rate_limiter.h"
+#include "utils.h"
+
+typedef enum {
+    SLOT_EMPTY,
+    SLOT_WAITING,
+    SLOT_RUNNING,
+    SLOT_DONE,
+    SLOT_FAILED
+} slot_state_t;
+
+struct fetcher;
+
+typedef struct {
+    struct fetcher *owner;
+    int page;
+    slot_state_t state;
+    CURL *curl;
+    http_transfer_t transfer;
+    http_sink_t sink;
+    http_buffer_t buffer;
+    char url[2048];
+    int attempt;
+    long long retry_at;
+    /* Head of the queue: chunks go straight to the callbacks. */
+    bool streaming;
+    bool out_of_memory;
+} fetch_slot_t;
+
+typedef struct fetcher {
+    http_client_t *client;
+    const fetcher_options_t *options;
+    const fetcher_callbacks_t *callbacks;
+    CURLM *multi;
+    rate_limiter_t limiter;
+    fetch_slot_t *slots;
+    int parallel;
+    int head;
+    int next_page;
+    bool no_more_pages;
+    bool stop;
+} fetcher_t;
+
+static fetch_slot_t *slot_for(fetcher_t *fetcher, int page) {
+    return &fetcher->slots[(page - 1) % fetcher->parallel];
+}
+
+static void slot_begin(int attempt, void *user_data) {
+    fetch_slot_t *slot = (fetch_slot_t *)user_data;
+    const fetcher_callbacks_t *callbacks = slot->owner->callbacks;
+    if (slot->streaming) {
+        if (attempt > 0) {
+            callbacks->page_begin(attempt, callbacks->user_data);
+        }
+        return;
+    }
+    http_buffer_free(&slot->buffer);
+    http_buffer_init(&slot->buffer);
+}
+
+static bool slot_chunk(const char *data, size_t len, void *user_data) {
+    fetch_slot_t *slot = (fetch_slot_t *)user_data;
+    if (slot->streaming) {
+        const fetcher_callbacks_t *callbacks = slot->owner->callbacks;
+        return callbacks->page_chunk(data, len, callbacks->user_data);
+    }
+    if (!http_buffer_append(&slot->buffer, data, len)) {
+        slot->out_of_memory = true;
+        return false;
+    }
+    return true;
+}
+
+static void slot_release(fetch_slot_t *slot) {
+    http_buffer_free(&slot->buffer);
+    slot->state = SLOT_EMPTY;
+    slot->streaming = false;
+    slot->out_of_memory = false;
+    slot->attempt = 0;
+}
+
+/* Hands whatever the head page buffered so far to the callbacks and streams the rest. */
+static void promote(fetcher_t *fetcher, fetch_slot_t *slot) {
+    if (slot->state != SLOT_RUNNING && slot->state != SLOT_WAITING) {
+        return;
+    }
+    const fetcher_callbacks_t *callbacks = fetcher->callbacks;
+    callbacks->page_begin(0, callbacks->user_data);
+    if (slot->buffer.size > 0) {
+        callbacks->page_chunk(slot->buffer.data, slot->buffer.size, callbacks->user_data);
+    }
+    http_buffer_free(&slot->buffer);
+    slot->streaming = true;
+}
+
+static bool start_attempt(fetcher_t *fetcher, fetch_slot_t *slot) {
+    slot->sink.begin(slot->attempt, slot->sink.user_data);
+    slot->out_of_memory = false;
+    http_transfer_prepare(&slot->transfer, fetcher->client, slot->curl, slot->url, fetcher->options->timeout_seconds,
+                          &slot->sink);
+    curl_easy_setopt(slot->curl, CURLOPT_PRIVATE, (void *)slot);
+    if (curl_multi_add_handle(fetcher->multi, slot->curl) != CURLM_OK) {
+        slot->state = SLOT_FAILED;
+        return false;
+    }
+    slot->state = SLOT_RUNNING;
+    return true;
+}
+
+static void launch_ready(fetcher_t *fetcher, long long now_ms) {
+    for (int page = fetcher->head; page < fetcher->next_page; ++page) {
+        fetch_slot_t *slot = slot_for(fetcher, page);
+        if (slot->state == SLOT_WAITING && slot->retry_at <= now_ms) {
+            if (!rate_limiter_try_acquire(&fetcher->limiter, now_ms)) {
+                return;
+            }
+            start_attempt(fetcher, slot);
+        }
+    }
+    while (!fetcher->stop && !fetcher->no_more_pages && fetcher->next_page < fetcher->head + fetcher->parallel) {
+        fetch_slot_t *slot = slot_for(fetcher, fetcher->next_page);
+        const fetcher_callbacks_t *callbacks = fetcher->callbacks;
+        if (!callbacks->page_url(fetcher->next_page, slot->url, sizeof(slot->url), callbacks->user_data)) {
+            fetcher->no_more_pages = true;
+            return;
+        }
+        slot->page = fetcher->next_page;
+        slot->attempt = 0;
+        slot->state = SLOT_WAITING;
+        if (slot->page == fetcher->head) {
+            promote(fetcher, slot);
+        }
+        http_local_t local = http_client_serve_local(fetcher->client, slot->url, &slot->sink, NULL);
+        if (local != HTTP_LOCAL_MISS) {
+            slot->state = local == HTTP_LOCAL_SERVED ? SLOT_DONE : SLOT_FAILED;
+            fetcher->next_page++;
+            continue;
+        }
+        if (!rate_limiter_try_acquire(&fetcher->limiter, now_ms)) {
+            slot_release(slot);
+            return;
+        }
+        start_attempt(fetcher, slot);
+        fetcher->next_page++;
+    }
+}
+
+static void handle_done(fetcher_t *fetcher, CURL *easy, CURLcode res) {
+    char *priv = NULL;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+    fetch_slot_t *slot = (fetch_slot_t *)(void *)priv;
+    curl_multi_remove_handle(fetcher->multi, easy);
+    if (!slot) {
+        return;
+    }
+    http_result_t outcome = http_transfer_result(&slot->transfer, res, NULL);
+    if (slot->out_of_memory) {
+        outcome = HTTP_RESULT_FAILED;
+    }
+    http_transfer_complete(&slot->transfer, outcome);
+    if (outcome == HTTP_RESULT_RETRY && slot->attempt < fetcher->options->retries) {
+        stats_record_retry(fetcher->client->stats, http_backoff_ms(slot->attempt));
+        slot->retry_at = utils_now_ms() + http_backoff_ms(slot->attempt);
+        slot->attempt++;
+        slot->state = SLOT_WAITING;
+        return;
+    }
+    slot->state = outcome == HTTP_RESULT_OK ? SLOT_DONE : SLOT_FAILED;
+}
+
+static int deliver_ready(fetcher_t *fetcher) {
+    const fetcher_callbacks_t *callbacks = fetcher->callbacks;
+    while (!fetcher->stop && fetcher->head < fetcher->next_page) {
+        fetch_slot_t *slot = slot_for(fetcher, fetcher->head);
+        if (slot->state == SLOT_FAILED) {
+            fprintf(stderr, "HTTP request failed for %s\n", slot->url);
+            return -1;
+        }
+        if (slot->state != SLOT_DONE) {
+            return 0;
+        }
+        if (!slot->streaming) {
+            callbacks->page_begin(0, callbacks->user_data);
+            if (slot->buffer.size > 0) {
+                callbacks->page_chunk(slot->buffer.data, slot->buffer.size, callbacks->user_data);
+            }
+        }
+        bool more = callbacks->page_end(slot->page, callbacks->user_data);
+        slot_release(slot);
+        fetcher->head++;
+        if (!more) {
+            fetcher->stop = true;
+            return 0;
+        }
+        if (fetcher->head < fetcher->next_page) {
+            promote(fetcher, slot_for(fetcher, fetcher->head));
+        }
+    }
+    return 0;
+}
+
+static long next_wait_ms(fetcher_t *fetcher) {
+    long long now_ms = utils_now_ms();
+    long wait = 1000;
+    bool wants_slot = !fetcher->no_more_pages && fetcher->next_page < fetcher->head + fetcher->parallel;
+    for (int page = fetcher->head; page < fetcher->next_page; ++page) {
+        fetch_slot_t *slot = slot_for(fetcher, page);
+        if (slot->state == SLOT_WAITING) {
+            long until = slot->retry_at > now_ms ? (long)(slot->retry_at - now_ms) : 0;
+            if (until < wait) {
+                wait = until;
+            }
+            if (until == 0) {
+                wants_slot = true;
+            }
+        }
+    }
+    if (wants_slot) {
+        long limiter_wait = rate_limiter_wait_ms(&fetcher->limiter, now_ms);
+        if (limiter_wait < wait) {
+            wait = limiter_wait;
+        }
+    }
+    return wait;
+}
+
+int fetcher_run(http_client_t *client, const fetcher_options_t *options, const fetcher_callbacks_t *callbacks) {
+    if (!client || !options || !callbacks || !callbacks->page_url || !callbacks->page_begin || !callbacks->page_chunk ||
+        !callbacks->page_end) {
+        return -1;
+    }
+    fetcher_t fetcher;
+    memset(&fetcher, 0, sizeof(fetcher));
+    fetcher.client = client;
+    fetcher.options = options;
+    fetcher.callbacks = callbacks;
+    fetcher.parallel = options->parallel > 0 ? options->parallel : 1;
+    fetcher.head = 1;
+    fetcher.next_page = 1;
+    rate_limiter_init(&fetcher.limiter, options->interval_ms, options->burst, utils_now_ms());
+
+    fetcher.multi = curl_multi_init();
+    fetcher.slots = (fetch_slot_t *)calloc((size_t)fetcher.parallel, sizeof(fetch_slot_t));
+    if (!fetcher.multi || !fetcher.slots) {
+        if (fetcher.multi) {
+            curl_multi_cleanup(fetcher.multi);
+        }
+        free(fetcher.slots);
+        return -1;
+    }
+    http_client_configure_multi(client, fetcher.multi, fetcher.parallel);
+    int result = 0;
+    for (int i = 0; i < fetcher.parallel; ++i) {
+        fetch_slot_t *slot = &fetcher.slots[i];
+        slot->owner = &fetcher;
+        slot->curl = http_client_acquire(client);
+        slot->sink.begin = slot_begin;
+        slot->sink.chunk = slot_chunk;
+        slot->sink.user_data = slot;
+        http_buffer_init(&slot->buffer);
+        if (!slot->curl) {
+            result = -1;
+        }
+    }
+
+    while (result == 0 && !fetcher.stop) {
+        launch_ready(&fetcher, utils_now_ms());
+        if (fetcher.no_more_pages && fetcher.head >= fetcher.next_page) {
+            break;
+        }
+        int running = 0;
+        curl_multi_perform(fetcher.multi, &running);
+        CURLMsg *msg;
+        int left = 0;
+        while ((msg = curl_multi_info_read(fetcher.multi, &left)) != NULL) {
+            if (msg->msg == CURLMSG_DONE) {
+                handle_done(&fetcher, msg->easy_handle, msg->data.result);
+            }
+        }
+        if (deliver_ready(&fetcher) != 0) {
+            result = -1;
+            break;
+        }
+        if (fetcher.stop) {
+            break;
+        }
+        curl_multi_poll(fetcher.multi, NULL, 0, (int)next_wait_ms(&fetcher), NULL);
+    }
+
+    for (int i = 0; i < fetcher.parallel; ++i) {
+        fetch_slot_t *slot = &fetcher.slots[i];
+        if (slot->curl) {
+            if (slot->state == SLOT_RUNNING) {
+                curl_multi_remove_handle(fetcher.multi, slot->curl);
+                http_transfer_abort(&slot->transfer);
+            }
+            http_client_release(client, slot->curl);
+        }
+        http_buffer_free(&slot->buffer);
+    }
+    free(fetcher.slots);
+    curl_multi_cleanup(fetcher.multi);
+    return result;
+}
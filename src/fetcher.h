@@ -0,0 +1,37 @@
+#ifndef FETCHER_H
+#define FETCHER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "http.h"
+
+/*
+ * Concurrent page fetcher. Pages 1, 2, ... are requested through curl multi
+ * with up to `parallel` pages in flight; the page at the head of the queue is
+ * streamed into the callbacks while later pages are buffered, so callbacks
+ * always see pages strictly in order.
+ */
+typedef bool (*fetcher_url_callback_t)(int page, char *url, size_t cap, void *user_data);
+/* Called after a page was fully delivered; returning false stops fetching. */
+typedef bool (*fetcher_page_end_callback_t)(int page, void *user_data);
+
+typedef struct {
+    fetcher_url_callback_t page_url;
+    http_begin_callback_t page_begin;
+    http_chunk_callback_t page_chunk;
+    fetcher_page_end_callback_t page_end;
+    void *user_data;
+} fetcher_callbacks_t;
+
+typedef struct {
+    int parallel;
+    long interval_ms;
+    int burst;
+    long timeout_seconds;
+    int retries;
+} fetcher_options_t;
+
+int fetcher_run(http_client_t *client, const fetcher_options_t *options, const fetcher_callbacks_t *callbacks);
+
+#endif
@@ -0,0 +1,287 @@
+#include "fixture_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extractor.h"
+#include "thread.h"
+#include "utils.h"
+
+/* How far, in files per worker, extraction may run ahead of the output.
+ * Finished files wait in memory until they are written. */
+#define FIXTURE_POOL_WINDOW 16
+
+typedef struct {
+    article_batch_t batch;
+    bool done;
+    bool failed;
+} file_result_t;
+
+typedef struct fixture_pool fixture_pool_t;
+
+typedef struct {
+    fixture_pool_t *pool;
+    /* Guards head and tail: the owner takes from the head, thieves from
+     * the tail. */
+    thread_mutex_t lock;
+    size_t *tasks;
+    size_t head;
+    size_t tail;
+    extractor_t extractor;
+    stats_t stats;
+    size_t current;
+    thread_t thread;
+} pool_worker_t;
+
+struct fixture_pool {
+    char *const *paths;
+    size_t count;
+    fixture_order_t order;
+    size_t window;
+    pool_worker_t *workers;
+    size_t jobs;
+    file_result_t *results;
+
+    /* Guards everything below and the `done` flags. */
+    thread_mutex_t lock;
+    thread_cond_t finished;
+    thread_cond_t advanced;
+    size_t *completed;
+    size_t completed_len;
+    size_t next_write;
+    size_t in_flight;
+};
+
+static bool take_task(fixture_pool_t *pool, pool_worker_t *self, size_t *index) {
+    thread_mutex_lock(&self->lock);
+    bool found = self->head < self->tail;
+    if (found) {
+        *index = self->tasks[self->head++];
+    }
+    thread_mutex_unlock(&self->lock);
+    size_t id = (size_t)(self - pool->workers);
+    for (size_t k = 1; !found && k < pool->jobs; ++k) {
+        pool_worker_t *victim = &pool->workers[(id + k) % pool->jobs];
+        thread_mutex_lock(&victim->lock);
+        found = victim->head < victim->tail;
+        if (found) {
+            *index = victim->tasks[--victim->tail];
+        }
+        thread_mutex_unlock(&victim->lock);
+    }
+    return found;
+}
+
+/* Blocks while the output lags too far behind. In input order the file
+ * about to be written is always inside the window, so its worker never
+ * waits here. */
+static void wait_for_window(fixture_pool_t *pool, size_t index) {
+    thread_mutex_lock(&pool->lock);
+    if (pool->order == FIXTURE_ORDER_INPUT) {
+        while (index >= pool->next_write + pool->window) {
+            thread_cond_wait(&pool->advanced, &pool->lock);
+        }
+    } else {
+        while (pool->in_flight >= pool->window) {
+            thread_cond_wait(&pool->advanced, &pool->lock);
+        }
+        pool->in_flight++;
+    }
+    thread_mutex_unlock(&pool->lock);
+}
+
+static void keep_batch(void *user_data, article_batch_t *batch) {
+    pool_worker_t *worker = (pool_worker_t *)user_data;
+    article_batch_t *kept = &worker->pool->results[worker->current].batch;
+    article_batch_t empty = *kept;
+    *kept = *batch;
+    *batch = empty;
+}
+
+static void run_file(pool_worker_t *worker, size_t index) {
+    fixture_pool_t *pool = worker->pool;
+    char *data = NULL;
+    size_t size = 0;
+    bool failed = utils_read_file(pool->paths[index], &data, &size) != 0;
+    if (!failed) {
+        worker->current = index;
+        extractor_consume_html(&worker->extractor, data, size);
+        free(data);
+    }
+    thread_mutex_lock(&pool->lock);
+    pool->results[index].done = true;
+    pool->results[index].failed = failed;
+    pool->completed[pool->completed_len++] = index;
+    thread_cond_signal(&pool->finished);
+    thread_mutex_unlock(&pool->lock);
+}
+
+static int worker_run(void *arg) {
+    pool_worker_t *worker = (pool_worker_t *)arg;
+    size_t index;
+    while (take_task(worker->pool, worker, &index)) {
+        wait_for_window(worker->pool, index);
+        run_file(worker, index);
+    }
+    return 0;
+}
+
+static int write_results(fixture_pool_t *pool, writer_t *writer, stats_t *stats) {
+    int exit_code = 0;
+    thread_mutex_lock(&pool->lock);
+    for (size_t written = 0; written < pool->count; ++written) {
+        size_t index;
+        for (;;) {
+            if (pool->order == FIXTURE_ORDER_INPUT) {
+                index = written;
+            } else {
+                index = written < pool->completed_len ? pool->completed[written] : pool->count;
+            }
+            if (index < pool->count && pool->results[index].done) {
+                break;
+            }
+            thread_cond_wait(&pool->finished, &pool->lock);
+        }
+        thread_mutex_unlock(&pool->lock);
+
+        file_result_t *result = &pool->results[index];
+        if (result->failed) {
+            exit_code = 1;
+        }
+        if (result->batch.len > 0) {
+            long long start = stats ? utils_now_us() : 0;
+            writer_submit_batch(writer, &result->batch);
+            if (stats) {
+                stats->write_us += utils_now_us() - start;
+            }
+        }
+        article_batch_free(&result->batch);
+
+        thread_mutex_lock(&pool->lock);
+        if (pool->order == FIXTURE_ORDER_INPUT) {
+            pool->next_write = written + 1;
+        } else {
+            pool->in_flight--;
+        }
+        thread_cond_broadcast(&pool->advanced);
+    }
+    thread_mutex_unlock(&pool->lock);
+    return exit_code;
+}
+
+/* Sets up workers [0, jobs) with their extractors and queues; on failure,
+ * returns the number that were fully set up. */
+static size_t init_workers(fixture_pool_t *pool, const char *selectors, stats_t *stats) {
+    size_t per_worker = (pool->count + pool->jobs - 1) / pool->jobs;
+    for (size_t w = 0; w < pool->jobs; ++w) {
+        pool_worker_t *worker = &pool->workers[w];
+        worker->pool = pool;
+        stats_init(&worker->stats);
+        worker->tasks = (size_t *)malloc(per_worker * sizeof(size_t));
+        if (!worker->tasks) {
+            return w;
+        }
+        if (!extractor_init(&worker->extractor, NULL, 0)) {
+            free(worker->tasks);
+            return w;
+        }
+        if ((selectors && !extractor_set_selectors(&worker->extractor, selectors)) ||
+            !thread_mutex_init(&worker->lock)) {
+            extractor_free(&worker->extractor);
+            free(worker->tasks);
+            return w;
+        }
+        if (stats) {
+            extractor_set_stats(&worker->extractor, &worker->stats);
+        }
+        extractor_set_batch_sink(&worker->extractor, keep_batch, worker);
+        for (size_t i = w; i < pool->count; i += pool->jobs) {
+            worker->tasks[worker->tail++] = i;
+        }
+    }
+    return pool->jobs;
+}
+
+static void free_workers(fixture_pool_t *pool, size_t ready, stats_t *stats) {
+    for (size_t w = 0; w < ready; ++w) {
+        pool_worker_t *worker = &pool->workers[w];
+        if (stats) {
+            stats_merge(stats, &worker->stats);
+        }
+        stats_free(&worker->stats);
+        extractor_free(&worker->extractor);
+        thread_mutex_destroy(&worker->lock);
+        free(worker->tasks);
+    }
+}
+
+int fixture_pool_run(char *const *paths, size_t count, size_t jobs, fixture_order_t order, const char *selectors,
+                     writer_t *writer, stats_t *stats) {
+    if (count == 0) {
+        return 0;
+    }
+    fixture_pool_t pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.paths = paths;
+    pool.count = count;
+    pool.order = order;
+    pool.jobs = jobs < count ? jobs : count;
+    pool.window = pool.jobs * FIXTURE_POOL_WINDOW;
+    pool.results = (file_result_t *)calloc(count, sizeof(file_result_t));
+    pool.completed = (size_t *)malloc(count * sizeof(size_t));
+    pool.workers = (pool_worker_t *)calloc(pool.jobs, sizeof(pool_worker_t));
+    bool locked = thread_mutex_init(&pool.lock);
+    bool finished = locked && thread_cond_init(&pool.finished);
+    bool advanced = finished && thread_cond_init(&pool.advanced);
+    size_t ready = 0;
+    if (pool.results && pool.completed && pool.workers && advanced) {
+        for (size_t i = 0; i < count; ++i) {
+            article_batch_init(&pool.results[i].batch);
+        }
+        ready = init_workers(&pool, selectors, stats);
+    }
+
+    int exit_code = 1;
+    size_t started = 0;
+    long long start_us = stats ? utils_now_us() : 0;
+    if (ready == pool.jobs) {
+        while (started < pool.jobs && thread_start(&pool.workers[started].thread, worker_run, &pool.workers[started])) {
+            started++;
+        }
+    }
+    /* Workers that failed to start leave their queues to be stolen. */
+    if (started > 0) {
+        exit_code = write_results(&pool, writer, stats);
+        for (size_t w = 0; w < started; ++w) {
+            thread_join(&pool.workers[w].thread);
+        }
+        /* Wall clock, as in a single-threaded run; the writes made in this
+         * span are in write_us and come off the extract time. */
+        if (stats) {
+            stats->parse_us += utils_now_us() - start_us;
+        }
+    } else {
+        fprintf(stderr, "Failed to start the extraction workers\n");
+    }
+
+    free_workers(&pool, ready, stats);
+    if (pool.results) {
+        for (size_t i = 0; i < count; ++i) {
+            article_batch_free(&pool.results[i].batch);
+        }
+    }
+    if (advanced) {
+        thread_cond_destroy(&pool.advanced);
+    }
+    if (finished) {
+        thread_cond_destroy(&pool.finished);
+    }
+    if (locked) {
+        thread_mutex_destroy(&pool.lock);
+    }
+    free(pool.workers);
+    free(pool.completed);
+    free(pool.results);
+    return exit_code;
+}
@@ -0,0 +1,25 @@
+#ifndef FIXTURE_POOL_H
+#define FIXTURE_POOL_H
+
+#include <stddef.h>
+
+#include "stats.h"
+#include "writer.h"
+
+typedef enum {
+    FIXTURE_ORDER_INPUT,
+    FIXTURE_ORDER_COMPLETION
+} fixture_order_t;
+
+/*
+ * Extracts `count` files on `jobs` threads, each with its own extractor
+ * using `selectors` (NULL for the built-in rules), and writes the articles
+ * of every file as one batch: in the order of `paths`, or as files finish.
+ * Files are dealt round-robin to per-worker queues, and a worker whose queue
+ * runs dry steals from the back of the others'. Returns 0, or 1 if a file
+ * could not be read. `stats` may be NULL.
+ */
+int fixture_pool_run(char *const *paths, size_t count, size_t jobs, fixture_order_t order, const char *selectors,
+                     writer_t *writer, stats_t *stats);
+
+#endif
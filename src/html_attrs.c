@@ -0,0 +1,258 @@
+#include "html_attrs.h"
+
+#include <string.h>
+
+typedef struct {
+    size_t name_off;
+    size_t name_len;
+    size_t value_off;
+    size_t value_len;
+} attr_span_t;
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/* Same grammar as utils_parse_attr: attributes without `=` are skipped. */
+static bool next_attr(const char *src, size_t len, size_t *pos, attr_span_t *out) {
+    size_t p = *pos;
+    while (p < len) {
+        while (p < len && is_space(src[p])) {
+            ++p;
+        }
+        if (p >= len || src[p] == '>') {
+            break;
+        }
+        size_t key_start = p;
+        while (p < len && !is_space(src[p]) && src[p] != '=' && src[p] != '>') {
+            ++p;
+        }
+        size_t after_key = p;
+        while (p < len && is_space(src[p])) {
+            ++p;
+        }
+        if (p >= len || src[p] != '=') {
+            p = after_key;
+            continue;
+        }
+        ++p;
+        while (p < len && is_space(src[p])) {
+            ++p;
+        }
+        char quote = '\0';
+        if (p < len && (src[p] == '"' || src[p] == '\'')) {
+            quote = src[p++];
+        }
+        size_t value_start = p;
+        while (p < len) {
+            if (quote ? src[p] == quote : (is_space(src[p]) || src[p] == '>')) {
+                break;
+            }
+            ++p;
+        }
+        out->name_off = key_start;
+        out->name_len = after_key - key_start;
+        out->value_off = value_start;
+        out->value_len = p - value_start;
+        if (quote && p < len) {
+            ++p;
+        }
+        *pos = p;
+        return true;
+    }
+    *pos = len;
+    return false;
+}
+
+static unsigned char lower_ascii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static uint32_t name_hash(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= lower_ascii((unsigned char)name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool name_equals(const char *key, size_t key_len, const char *name, size_t name_len) {
+    if (key_len != name_len) {
+        return false;
+    }
+    if (memcmp(key, name, name_len) == 0) {
+        return true;
+    }
+    for (size_t i = 0; i < name_len; ++i) {
+        if (lower_ascii((unsigned char)key[i]) != lower_ascii((unsigned char)name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const html_attr_t *table_find(const html_attrs_t *attrs, const char *name, size_t name_len, uint32_t hash) {
+    for (size_t i = 0; i < HTML_ATTRS_BUCKETS; ++i) {
+        uint8_t slot = attrs->buckets[(hash + i) & (HTML_ATTRS_BUCKETS - 1)];
+        if (slot == 0) {
+            return NULL;
+        }
+        const html_attr_t *item = &attrs->items[slot - 1];
+        if (item->hash == hash && name_equals(attrs->src + item->name_off, item->name_len, name, name_len)) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void insert(html_attrs_t *attrs, const attr_span_t *span, uint32_t hash) {
+    html_attr_t *item = &attrs->items[attrs->count++];
+    item->name_off = (uint32_t)span->name_off;
+    item->name_len = (uint32_t)span->name_len;
+    item->value_off = (uint32_t)span->value_off;
+    item->value_len = (uint32_t)span->value_len;
+    item->hash = hash;
+    size_t bucket = hash & (HTML_ATTRS_BUCKETS - 1);
+    while (attrs->buckets[bucket] != 0) {
+        bucket = (bucket + 1) & (HTML_ATTRS_BUCKETS - 1);
+    }
+    attrs->buckets[bucket] = (uint8_t)attrs->count;
+}
+
+void html_attrs_reset(html_attrs_t *attrs, const char *src, size_t src_len) {
+    attrs->src = src ? src : "";
+    attrs->src_len = src ? src_len : 0;
+    attrs->started = false;
+    attrs->classes_ready = false;
+}
+
+bool html_attrs_get(html_attrs_t *attrs, const char *name, const char **value, size_t *value_len) {
+    if (!attrs->started) {
+        attrs->started = true;
+        attrs->count = 0;
+        attrs->resume = 0;
+        memset(attrs->buckets, 0, sizeof(attrs->buckets));
+    }
+    size_t name_len = strlen(name);
+    uint32_t hash = name_hash(name, name_len);
+    const html_attr_t *item = table_find(attrs, name, name_len, hash);
+    if (item) {
+        *value = attrs->src + item->value_off;
+        *value_len = item->value_len;
+        return true;
+    }
+    /* Index further attributes until the name turns up. Past the table
+     * capacity, attributes are only scanned, starting at the first one that
+     * did not fit. */
+    size_t pos = attrs->resume;
+    attr_span_t span;
+    while (pos < attrs->src_len && next_attr(attrs->src, attrs->src_len, &pos, &span)) {
+        const char *key = attrs->src + span.name_off;
+        bool match = name_equals(key, span.name_len, name, name_len);
+        if (attrs->count < HTML_ATTRS_CAP) {
+            uint32_t key_hash = match ? hash : name_hash(key, span.name_len);
+            if (table_find(attrs, key, span.name_len, key_hash)) {
+                attrs->resume = pos;
+                continue;
+            }
+            insert(attrs, &span, key_hash);
+            attrs->resume = pos;
+        }
+        if (match) {
+            *value = attrs->src + span.value_off;
+            *value_len = span.value_len;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t class_hash(const char *name, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t class_bit(uint64_t hash) {
+    return 1ULL << (hash >> 58);
+}
+
+void html_class_key_init(html_class_key_t *key, const char *name) {
+    key->name = name;
+    key->len = strlen(name);
+    key->hash = class_hash(name, key->len);
+    key->bit = class_bit(key->hash);
+}
+
+/* Bounds of the next class token at or after *pos. */
+static bool next_class(const char *value, size_t len, size_t *pos, size_t *start, size_t *token_len) {
+    size_t p = *pos;
+    while (p < len && is_space(value[p])) {
+        ++p;
+    }
+    if (p >= len) {
+        *pos = len;
+        return false;
+    }
+    *start = p;
+    while (p < len && !is_space(value[p])) {
+        ++p;
+    }
+    *token_len = p - *start;
+    *pos = p;
+    return true;
+}
+
+static void split_classes(html_attrs_t *attrs) {
+    attrs->classes_ready = true;
+    attrs->class_count = 0;
+    attrs->class_mask = 0;
+    attrs->class_value = NULL;
+    attrs->class_value_len = 0;
+    attrs->class_rest = 0;
+    if (!html_attrs_get(attrs, "class", &attrs->class_value, &attrs->class_value_len)) {
+        return;
+    }
+    size_t pos = 0;
+    size_t start = 0;
+    size_t len = 0;
+    while (attrs->class_count < HTML_CLASS_CAP &&
+           next_class(attrs->class_value, attrs->class_value_len, &pos, &start, &len)) {
+        uint64_t hash = class_hash(attrs->class_value + start, len);
+        attrs->class_hashes[attrs->class_count] = hash;
+        attrs->class_off[attrs->class_count] = (uint32_t)start;
+        attrs->class_len[attrs->class_count] = (uint32_t)len;
+        attrs->class_count++;
+        attrs->class_mask |= class_bit(hash);
+    }
+    attrs->class_rest = pos;
+}
+
+bool html_attrs_has_class(html_attrs_t *attrs, const html_class_key_t *key) {
+    if (!attrs->classes_ready) {
+        split_classes(attrs);
+    }
+    bool complete = attrs->class_rest >= attrs->class_value_len;
+    if ((attrs->class_mask & key->bit) == 0 && complete) {
+        return false;
+    }
+    for (size_t i = 0; i < attrs->class_count; ++i) {
+        if (attrs->class_hashes[i] == key->hash && attrs->class_len[i] == key->len &&
+            memcmp(attrs->class_value + attrs->class_off[i], key->name, key->len) == 0) {
+            return true;
+        }
+    }
+    size_t pos = attrs->class_rest;
+    size_t start = 0;
+    size_t len = 0;
+    while (next_class(attrs->class_value, attrs->class_value_len, &pos, &start, &len)) {
+        if (len == key->len && memcmp(attrs->class_value + start, key->name, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef HTML_ATTRS_H
+#define HTML_ATTRS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HTML_ATTRS_CAP 32
+#define HTML_ATTRS_BUCKETS 64
+#define HTML_CLASS_CAP 32
+
+typedef struct {
+    uint32_t name_off;
+    uint32_t name_len;
+    uint32_t value_off;
+    uint32_t value_len;
+    uint32_t hash;
+} html_attr_t;
+
+/*
+ * Index over the attribute string of one start tag. Lookups parse attributes
+ * only as far as they need to and file every attribute they pass in a small
+ * open-addressed table keyed by the lowercased name, so each attribute is
+ * parsed at most once per tag. Values are slices into the attribute string
+ * and are neither decoded nor NUL-terminated. Attributes beyond
+ * HTML_ATTRS_CAP are not indexed; lookups that miss scan them linearly.
+ */
+typedef struct {
+    const char *src;
+    size_t src_len;
+    bool started;
+    size_t count;
+    size_t resume;
+    html_attr_t items[HTML_ATTRS_CAP];
+    uint8_t buckets[HTML_ATTRS_BUCKETS];
+
+    /* Tokens of the class attribute, split on first use. `class_mask` has
+     * one bit per token hash and rejects most needles with a single AND. */
+    bool classes_ready;
+    const char *class_value;
+    size_t class_value_len;
+    size_t class_rest;
+    size_t class_count;
+    uint64_t class_mask;
+    uint64_t class_hashes[HTML_CLASS_CAP];
+    uint32_t class_off[HTML_CLASS_CAP];
+    uint32_t class_len[HTML_CLASS_CAP];
+} html_attrs_t;
+
+/* A class name hashed once up front, for repeated html_attrs_has_class() calls. */
+typedef struct {
+    const char *name;
+    size_t len;
+    uint64_t hash;
+    uint64_t bit;
+} html_class_key_t;
+
+void html_attrs_reset(html_attrs_t *attrs, const char *src, size_t src_len);
+/* `name` must be lowercase. If an attribute is repeated, the first one wins. */
+bool html_attrs_get(html_attrs_t *attrs, const char *name, const char **value, size_t *value_len);
+void html_class_key_init(html_class_key_t *key, const char *name);
+/* True if `key` is one of the whitespace-separated tokens of the class attribute. */
+bool html_attrs_has_class(html_attrs_t *attrs, const html_class_key_t *key);
+
+#endif
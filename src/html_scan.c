@@ -1,76 +1,222 @@
 #include "html_scan.h"
 
 #include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 
-static void emit_text(html_scanner_t *scanner) {
-    if (!scanner->capture_text || scanner->text_len == 0) {
-        scanner->text_len = 0;
+static bool spill_append(html_scanner_t *scanner, const char *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    if (scanner->spill_len + len > scanner->spill_cap) {
+        size_t cap = scanner->spill_cap ? scanner->spill_cap : 256;
+        while (cap < scanner->spill_len + len) {
+            cap *= 2;
+        }
+        char *new_spill = (char *)realloc(scanner->spill, cap);
+        if (!new_spill) {
+            return false;
+        }
+        scanner->spill = new_spill;
+        scanner->spill_cap = cap;
+    }
+    memcpy(scanner->spill + scanner->spill_len, data, len);
+    scanner->spill_len += len;
+    return true;
+}
+
+static void run_begin(html_scanner_t *scanner, const char *at) {
+    scanner->run_active = true;
+    scanner->run_start = at;
+    scanner->spill_len = 0;
+}
+
+/* Ends the current run just before `at` and returns it as one contiguous slice. */
+static size_t run_end(html_scanner_t *scanner, const char *at, const char **out) {
+    const char *data = NULL;
+    size_t len = 0;
+    if (scanner->run_active) {
+        size_t tail = scanner->run_start ? (size_t)(at - scanner->run_start) : 0;
+        if (scanner->spill_len > 0) {
+            spill_append(scanner, scanner->run_start, tail);
+            data = scanner->spill;
+            len = scanner->spill_len;
+        } else {
+            data = scanner->run_start;
+            len = tail;
+        }
+    }
+    scanner->run_active = false;
+    scanner->run_start = NULL;
+    scanner->spill_len = 0;
+    *out = data;
+    return len;
+}
+
+static void enter_text(html_scanner_t *scanner, const char *at) {
+    if (scanner->seeking) {
+        scanner->state = STATE_SEEK;
+        scanner->seek_match = 0;
         return;
     }
+    scanner->state = STATE_TEXT;
+    if (scanner->capture_text) {
+        run_begin(scanner, at);
+    }
+}
+
+static void dispatch(html_scanner_t *scanner, const token_t *token) {
+    scanner->tokens_emitted++;
+    if (!scanner->callback(token, scanner->user_data)) {
+        scanner->stopped = true;
+    }
+}
+
+static void emit_text_token(html_scanner_t *scanner, const char *text, size_t len) {
     token_t token;
-    memset(&token, 0, sizeof(token));
     token.type = TOKEN_TEXT;
-    size_t len = scanner->text_len < sizeof(token.text) - 1 ? scanner->text_len : sizeof(token.text) - 1;
-    memcpy(token.text, scanner->text_buf, len);
-    token.text[len] = '\0';
-    scanner->callback(&token, scanner->user_data);
-    scanner->text_len = 0;
+    token.tag = "";
+    token.tag_len = 0;
+    token.tag_id = HTML_TAG_UNKNOWN;
+    token.attrs = NULL;
+    token.attrs_len = 0;
+    token.text = text;
+    token.text_len = len;
+    token.attr_index = NULL;
+    dispatch(scanner, &token);
+}
+
+static void emit_text(html_scanner_t *scanner, const char *at) {
+    const char *text = NULL;
+    size_t len = run_end(scanner, at, &text);
+    if (scanner->capture_text && len > 0) {
+        emit_text_token(scanner, text, len);
+    }
 }
 
-static void emit_start_tag(html_scanner_t *scanner) {
+static void emit_start_tag(html_scanner_t *scanner, const char *attrs, size_t attrs_len) {
     token_t token;
-    memset(&token, 0, sizeof(token));
     token.type = TOKEN_START_TAG;
-    size_t len = scanner->tag_len < sizeof(token.tag) - 1 ? scanner->tag_len : sizeof(token.tag) - 1;
-    memcpy(token.tag, scanner->tag_buf, len);
-    token.tag[len] = '\0';
-    size_t attr_len = scanner->attrs_len < sizeof(token.attrs) - 1 ? scanner->attrs_len : sizeof(token.attrs) - 1;
-    memcpy(token.attrs, scanner->attrs_buf, attr_len);
-    token.attrs[attr_len] = '\0';
-    scanner->callback(&token, scanner->user_data);
-    if (scanner->self_closing) {
+    token.tag = scanner->tag_buf;
+    token.tag_len = scanner->tag_len;
+    token.tag_id = scanner->tag_id;
+    token.attrs = attrs;
+    token.attrs_len = attrs_len;
+    token.text = NULL;
+    token.text_len = 0;
+    html_attrs_reset(&scanner->attr_index, attrs, attrs_len);
+    token.attr_index = &scanner->attr_index;
+    dispatch(scanner, &token);
+    if (scanner->self_closing && !scanner->stopped) {
         token.type = TOKEN_END_TAG;
-        token.attrs[0] = '\0';
-        scanner->callback(&token, scanner->user_data);
+        token.attrs = NULL;
+        token.attrs_len = 0;
+        token.attr_index = NULL;
+        dispatch(scanner, &token);
     }
 }
 
 static void emit_end_tag(html_scanner_t *scanner) {
     token_t token;
-    memset(&token, 0, sizeof(token));
     token.type = TOKEN_END_TAG;
-    size_t len = scanner->tag_len < sizeof(token.tag) - 1 ? scanner->tag_len : sizeof(token.tag) - 1;
-    memcpy(token.tag, scanner->tag_buf, len);
-    token.tag[len] = '\0';
-    scanner->callback(&token, scanner->user_data);
+    token.tag = scanner->tag_buf;
+    token.tag_len = scanner->tag_len;
+    token.tag_id = scanner->tag_id;
+    token.attrs = NULL;
+    token.attrs_len = 0;
+    token.text = NULL;
+    token.text_len = 0;
+    token.attr_index = NULL;
+    dispatch(scanner, &token);
 }
 
 static void reset_tag_buffers(html_scanner_t *scanner) {
     scanner->tag_len = 0;
-    scanner->attrs_len = 0;
-    scanner->attrs_buf[0] = '\0';
     scanner->tag_buf[0] = '\0';
+    scanner->tag_hash = HTML_TAG_HASH_INIT;
+    scanner->tag_id = HTML_TAG_UNKNOWN;
     scanner->quote_char = '\0';
     scanner->self_closing = false;
 }
 
+bool html_token_attr(const token_t *token, const char *name, const char **value, size_t *value_len) {
+    if (token->type != TOKEN_START_TAG) {
+        return false;
+    }
+    if (token->attr_index) {
+        return html_attrs_get(token->attr_index, name, value, value_len);
+    }
+    html_attrs_t index;
+    html_attrs_reset(&index, token->attrs, token->attrs_len);
+    return html_attrs_get(&index, name, value, value_len);
+}
+
+bool html_token_has_class(const token_t *token, const html_class_key_t *key) {
+    if (token->type != TOKEN_START_TAG) {
+        return false;
+    }
+    if (token->attr_index) {
+        return html_attrs_has_class(token->attr_index, key);
+    }
+    html_attrs_t index;
+    html_attrs_reset(&index, token->attrs, token->attrs_len);
+    return html_attrs_has_class(&index, key);
+}
+
 void html_scanner_init(html_scanner_t *scanner, token_callback_t callback, void *user_data) {
     memset(scanner, 0, sizeof(*scanner));
     scanner->callback = callback;
     scanner->user_data = user_data;
     scanner->capture_text = true;
-    scanner->state = STATE_TEXT;
+    scanner->kernels = simd_scan_kernels();
+    enter_text(scanner, NULL);
+}
+
+void html_scanner_free(html_scanner_t *scanner) {
+    if (!scanner) {
+        return;
+    }
+    free(scanner->spill);
+    scanner->spill = NULL;
+    scanner->spill_len = 0;
+    scanner->spill_cap = 0;
+    scanner->run_active = false;
+    scanner->run_start = NULL;
+}
+
+void html_scanner_set_capture_raw_text(html_scanner_t *scanner, bool capture) {
+    scanner->capture_raw_text = capture;
+}
+
+bool html_scanner_skip_to(html_scanner_t *scanner, const char *pattern) {
+    size_t len = strlen(pattern);
+    if (len < 2 || len >= sizeof(scanner->seek_buf) || pattern[0] != '<') {
+        return false;
+    }
+    memcpy(scanner->seek_buf, pattern, len + 1);
+    scanner->seek_len = len;
+    scanner->seek_match = 0;
+    scanner->seeking = true;
+    if (scanner->state == STATE_TEXT) {
+        scanner->run_active = false;
+        scanner->run_start = NULL;
+        scanner->spill_len = 0;
+        scanner->state = STATE_SEEK;
+    }
+    return true;
 }
 
 void html_scanner_set_capture_text(html_scanner_t *scanner, bool capture) {
-    if (scanner->capture_text && !capture) {
-        emit_text(scanner);
+    if (scanner->capture_text && !capture && scanner->state == STATE_TEXT) {
+        emit_text(scanner, NULL);
     }
     scanner->capture_text = capture;
+    if (capture && scanner->state == STATE_TEXT && !scanner->run_active) {
+        run_begin(scanner, NULL);
+    }
 }
 
-static void handle_comment_state(html_scanner_t *scanner, char c) {
+static void handle_comment_state(html_scanner_t *scanner, char c, const char *next) {
     if (scanner->state == STATE_COMMENT_START) {
         if (c == '-' && scanner->comment_dash_count < 2) {
             scanner->comment_dash_count++;
@@ -88,7 +234,7 @@ static void handle_comment_state(html_scanner_t *scanner, char c) {
                 scanner->comment_dash_count++;
             }
         } else if (c == '>' && scanner->comment_dash_count >= 2) {
-            scanner->state = STATE_TEXT;
+            enter_text(scanner, next);
             scanner->comment_dash_count = 0;
         } else {
             scanner->comment_dash_count = 0;
@@ -97,50 +243,210 @@ static void handle_comment_state(html_scanner_t *scanner, char c) {
     }
     if (scanner->state == STATE_SKIP_DECL) {
         if (c == '>') {
-            scanner->state = STATE_TEXT;
+            enter_text(scanner, next);
         }
     }
 }
 
-static void finish_tag(html_scanner_t *scanner) {
-    while (scanner->attrs_len > 0) {
-        char ch = scanner->attrs_buf[scanner->attrs_len - 1];
-        if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
-            scanner->attrs_len--;
-        } else if (ch == '/') {
-            scanner->attrs_len--;
-            scanner->self_closing = true;
-        } else {
-            break;
-        }
+/* Ends a raw text body just before `at`, dropping the last `trim` bytes. */
+static void emit_raw_text(html_scanner_t *scanner, const char *at, size_t trim) {
+    if (!scanner->run_active) {
+        return;
+    }
+    const char *text = NULL;
+    size_t len = run_end(scanner, at, &text);
+    if (len > trim) {
+        emit_text_token(scanner, text, len - trim);
+    }
+}
+
+static bool is_raw_text_tag(html_tag_t id) {
+    return id == HTML_TAG_SCRIPT || id == HTML_TAG_STYLE || id == HTML_TAG_SVG || id == HTML_TAG_NOSCRIPT;
+}
+
+static void enter_raw_text(html_scanner_t *scanner, html_tag_t tag, const char *at) {
+    scanner->state = STATE_RAW_TEXT;
+    scanner->raw_tag = tag;
+    scanner->raw_match = 0;
+    if (scanner->capture_raw_text) {
+        run_begin(scanner, at);
     }
-    scanner->attrs_buf[scanner->attrs_len] = '\0';
+}
+
+static void finish_tag(html_scanner_t *scanner, const char *at) {
+    html_tag_t raw_tag = HTML_TAG_UNKNOWN;
     if (scanner->closing_tag) {
         emit_end_tag(scanner);
     } else {
-        emit_start_tag(scanner);
+        const char *attrs = NULL;
+        size_t attrs_len = run_end(scanner, at, &attrs);
+        while (attrs_len > 0) {
+            char ch = attrs[attrs_len - 1];
+            if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+                attrs_len--;
+            } else if (ch == '/') {
+                attrs_len--;
+                scanner->self_closing = true;
+            } else {
+                break;
+            }
+        }
+        emit_start_tag(scanner, attrs, attrs_len);
+        if (!scanner->self_closing && is_raw_text_tag(scanner->tag_id)) {
+            raw_tag = scanner->tag_id;
+        }
     }
     reset_tag_buffers(scanner);
     scanner->closing_tag = false;
-    scanner->state = STATE_TEXT;
+    if (raw_tag != HTML_TAG_UNKNOWN) {
+        enter_raw_text(scanner, raw_tag, at + 1);
+    } else {
+        enter_text(scanner, at + 1);
+    }
+}
+
+/* Advances the match of "</name" against the raw text, case-insensitively. The
+ * name must be followed by whitespace, '/' or '>' to close the element. */
+static void handle_raw_text_state(html_scanner_t *scanner, char c, const char *at) {
+    const char *name = html_tag_name(scanner->raw_tag);
+    size_t name_len = strlen(name);
+    size_t pattern_len = name_len + 2;
+    if (scanner->raw_match < pattern_len) {
+        char expected = scanner->raw_match == 0 ? '<' : scanner->raw_match == 1 ? '/' : name[scanner->raw_match - 2];
+        if ((char)tolower((unsigned char)c) == expected) {
+            scanner->raw_match++;
+        } else {
+            scanner->raw_match = c == '<' ? 1 : 0;
+        }
+        return;
+    }
+    if (c != '>' && c != '/' && !isspace((unsigned char)c)) {
+        scanner->raw_match = c == '<' ? 1 : 0;
+        return;
+    }
+    emit_raw_text(scanner, at, pattern_len);
+    scanner->raw_match = 0;
+    reset_tag_buffers(scanner);
+    memcpy(scanner->tag_buf, name, name_len + 1);
+    scanner->tag_len = name_len;
+    scanner->tag_id = scanner->raw_tag;
+    scanner->closing_tag = true;
+    scanner->state = STATE_END_TAG_REST;
+    if (c == '>' && !scanner->stopped) {
+        finish_tag(scanner, at);
+    }
+}
+
+static bool is_tag_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '-' || c == '_' || c == ':';
+}
+
+/* Advances the seek over the tag candidate starting at the last '<'. A match
+ * of the pattern resumes scanning inside the matched tag name. Comments and
+ * raw text start tags also end the seek: the tokenizer takes them over, so
+ * nothing inside them matches, and the seek resumes once they close. Returns
+ * true when `c` has to be processed again in the new state. */
+static bool handle_seek_state(html_scanner_t *scanner, char c) {
+    if (c == '<') {
+        reset_tag_buffers(scanner);
+        scanner->seek_match = 1;
+        scanner->seek_on_pattern = true;
+        return false;
+    }
+    if (scanner->seek_match == 0) {
+        return false;
+    }
+    if (scanner->seek_match == 1 && c == '!') {
+        scanner->seek_match = 0;
+        scanner->state = STATE_COMMENT_START;
+        scanner->comment_dash_count = 0;
+        return false;
+    }
+    bool in_name = scanner->tag_len + 1 == scanner->seek_match;
+    if (in_name && scanner->tag_len > 0 && !is_tag_name_char(c)) {
+        scanner->tag_buf[scanner->tag_len] = '\0';
+        html_tag_t id = html_tag_lookup_hashed(scanner->tag_buf, scanner->tag_len, scanner->tag_hash);
+        if (is_raw_text_tag(id)) {
+            scanner->seek_match = 0;
+            scanner->closing_tag = false;
+            scanner->state = STATE_TAG_NAME;
+            return true;
+        }
+    }
+    char lower = (char)tolower((unsigned char)c);
+    bool on_pattern = scanner->seek_on_pattern && lower == scanner->seek_buf[scanner->seek_match];
+    if (!on_pattern && !(in_name && is_tag_name_char(c))) {
+        scanner->seek_match = 0;
+        return false;
+    }
+    scanner->seek_on_pattern = on_pattern;
+    if (in_name && scanner->tag_len + 1 < sizeof(scanner->tag_buf)) {
+        scanner->tag_buf[scanner->tag_len++] = lower;
+        scanner->tag_hash = HTML_TAG_HASH_STEP(scanner->tag_hash, (unsigned char)lower);
+    }
+    if (++scanner->seek_match < scanner->seek_len || !on_pattern) {
+        return false;
+    }
+    scanner->seeking = false;
+    reset_tag_buffers(scanner);
+    size_t name_start = scanner->seek_buf[1] == '/' ? 2 : 1;
+    scanner->closing_tag = name_start == 2;
+    for (size_t i = name_start; i < scanner->seek_len; ++i) {
+        scanner->tag_buf[scanner->tag_len++] = scanner->seek_buf[i];
+        scanner->tag_hash = HTML_TAG_HASH_STEP(scanner->tag_hash, (unsigned char)scanner->seek_buf[i]);
+    }
+    scanner->tag_buf[scanner->tag_len] = '\0';
+    scanner->state = STATE_TAG_NAME;
+    return false;
 }
 
-void html_scanner_feed(html_scanner_t *scanner, const char *data, size_t len, bool final_chunk) {
+/* Jumps over bytes that cannot change the current state. */
+static const char *skip_plain(const html_scanner_t *scanner, const char *ptr, const char *end) {
+    const simd_kernels_t *k = scanner->kernels;
+    switch (scanner->state) {
+        case STATE_TEXT:
+            return k->find1(ptr, end, '<');
+        case STATE_TAG_REST:
+            if (scanner->quote_char) {
+                return k->find1(ptr, end, scanner->quote_char);
+            }
+            return k->find3(ptr, end, '"', '\'', '>');
+        case STATE_END_TAG_REST:
+        case STATE_SKIP_DECL:
+            return k->find1(ptr, end, '>');
+        case STATE_COMMENT:
+            return scanner->comment_dash_count == 0 ? k->find1(ptr, end, '-') : ptr;
+        case STATE_RAW_TEXT:
+            return scanner->raw_match == 0 ? k->find1(ptr, end, '<') : ptr;
+        case STATE_SEEK:
+            return scanner->seek_match == 0 ? k->find1(ptr, end, scanner->seek_buf[0]) : ptr;
+        default:
+            return ptr;
+    }
+}
+
+bool html_scanner_feed(html_scanner_t *scanner, const char *data, size_t len, bool final_chunk) {
+    if (scanner->stopped) {
+        return false;
+    }
     const char *ptr = data;
     const char *end = data + len;
-    while (ptr < end) {
+    if (scanner->run_active) {
+        scanner->run_start = data;
+    }
+    while (ptr < end && !scanner->stopped) {
+        ptr = skip_plain(scanner, ptr, end);
+        if (ptr == end) {
+            break;
+        }
         char c = *ptr++;
         switch (scanner->state) {
             case STATE_TEXT:
                 if (c == '<') {
-                    emit_text(scanner);
+                    scanner->state = STATE_TAG_OPEN;
+                    emit_text(scanner, ptr - 1);
                     reset_tag_buffers(scanner);
                     scanner->closing_tag = false;
-                    scanner->state = STATE_TAG_OPEN;
-                } else if (scanner->capture_text) {
-                    if (scanner->text_len + 1 < sizeof(scanner->text_buf)) {
-                        scanner->text_buf[scanner->text_len++] = c;
-                    }
                 }
                 break;
             case STATE_TAG_OPEN:
@@ -161,67 +467,80 @@ void html_scanner_feed(html_scanner_t *scanner, const char *data, size_t len, bo
                 }
                 break;
             case STATE_TAG_NAME:
-                if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == ':' ) {
+                if (is_tag_name_char(c)) {
                     if (scanner->tag_len + 1 < sizeof(scanner->tag_buf)) {
-                        scanner->tag_buf[scanner->tag_len++] = (char)tolower((unsigned char)c);
+                        char lower = (char)tolower((unsigned char)c);
+                        scanner->tag_buf[scanner->tag_len++] = lower;
+                        scanner->tag_hash = HTML_TAG_HASH_STEP(scanner->tag_hash, (unsigned char)lower);
                     }
                 } else {
                     scanner->tag_buf[scanner->tag_len] = '\0';
+                    scanner->tag_id = html_tag_lookup_hashed(scanner->tag_buf, scanner->tag_len, scanner->tag_hash);
+                    ptr--;
                     if (scanner->closing_tag) {
                         scanner->state = STATE_END_TAG_REST;
                     } else {
                         scanner->state = STATE_TAG_REST;
+                        run_begin(scanner, ptr);
                     }
-                    ptr--;
                 }
                 break;
             case STATE_TAG_REST:
                 if (scanner->quote_char) {
                     if (c == scanner->quote_char) {
-                        if (scanner->attrs_len + 1 < sizeof(scanner->attrs_buf)) {
-                            scanner->attrs_buf[scanner->attrs_len++] = c;
-                        }
                         scanner->quote_char = '\0';
-                    } else {
-                        if (scanner->attrs_len + 1 < sizeof(scanner->attrs_buf)) {
-                            scanner->attrs_buf[scanner->attrs_len++] = c;
-                        }
-                    }
-                } else {
-                    if (c == '"' || c == '\'') {
-                        if (scanner->attrs_len + 1 < sizeof(scanner->attrs_buf)) {
-                            scanner->attrs_buf[scanner->attrs_len++] = c;
-                        }
-                        scanner->quote_char = c;
-                    } else if (c == '>') {
-                        finish_tag(scanner);
-                    } else if (c == '/') {
-                        scanner->self_closing = true;
-                    } else {
-                        if (scanner->attrs_len + 1 < sizeof(scanner->attrs_buf)) {
-                            scanner->attrs_buf[scanner->attrs_len++] = c;
-                        }
                     }
+                } else if (c == '"' || c == '\'') {
+                    scanner->quote_char = c;
+                } else if (c == '>') {
+                    finish_tag(scanner, ptr - 1);
                 }
                 break;
             case STATE_END_TAG_REST:
                 if (c == '>') {
-                    finish_tag(scanner);
+                    finish_tag(scanner, ptr - 1);
                 }
                 break;
             case STATE_COMMENT_START:
             case STATE_COMMENT:
             case STATE_SKIP_DECL:
-                handle_comment_state(scanner, c);
+                handle_comment_state(scanner, c, ptr);
+                break;
+            case STATE_RAW_TEXT:
+                handle_raw_text_state(scanner, c, ptr - 1);
+                break;
+            case STATE_SEEK:
+                if (handle_seek_state(scanner, c)) {
+                    ptr--; /* reprocess */
+                }
                 break;
         }
     }
-    if (final_chunk) {
-        emit_text(scanner);
+    scanner->bytes_scanned += (size_t)(ptr - data);
+    if (scanner->stopped) {
+        scanner->run_active = false;
+        scanner->run_start = NULL;
+        scanner->spill_len = 0;
+        return false;
     }
+    if (final_chunk && scanner->state == STATE_TEXT) {
+        emit_text(scanner, end);
+    } else if (final_chunk && scanner->state == STATE_RAW_TEXT) {
+        emit_raw_text(scanner, end, 0);
+    }
+    if (scanner->run_active) {
+        if (scanner->run_start) {
+            spill_append(scanner, scanner->run_start, (size_t)(end - scanner->run_start));
+        }
+        scanner->run_start = NULL;
+    }
+    return !scanner->stopped;
 }
 
 void html_scanner_finish(html_scanner_t *scanner) {
-    emit_text(scanner);
+    if (scanner->state == STATE_TEXT && !scanner->stopped) {
+        emit_text(scanner, NULL);
+    } else if (scanner->state == STATE_RAW_TEXT && !scanner->stopped) {
+        emit_raw_text(scanner, NULL, 0);
+    }
 }
-
@@ -4,25 +4,47 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "html_attrs.h"
+#include "html_tags.h"
+#include "simd_scan.h"
+
 typedef enum {
     TOKEN_START_TAG,
     TOKEN_END_TAG,
     TOKEN_TEXT
 } token_type_t;
 
+/*
+ * Tokens do not own their data. `tag` is the lowercased tag name kept by the
+ * scanner and is NUL-terminated; `tag_id` is its interned id, HTML_TAG_UNKNOWN
+ * for text tokens and for names outside HTML_TAG_LIST. `attrs` and `text` are slices into the buffer
+ * passed to html_scanner_feed(), or into the scanner's spill buffer when the
+ * token straddles two feed chunks; they are NOT NUL-terminated. Start tags
+ * carry `attr_index`, the scanner's attribute index for `attrs`; look values
+ * up with html_token_attr(). All pointers are only valid for the duration of
+ * the callback.
+ */
 typedef struct {
     token_type_t type;
-    char tag[64];
-    char attrs[1024];
-    char text[2048];
+    const char *tag;
+    size_t tag_len;
+    html_tag_t tag_id;
+    const char *attrs;
+    size_t attrs_len;
+    const char *text;
+    size_t text_len;
+    html_attrs_t *attr_index;
 } token_t;
 
-typedef void (*token_callback_t)(const token_t *token, void *user_data);
+/* Returning false stops the scanner: the rest of the document is ignored. */
+typedef bool (*token_callback_t)(const token_t *token, void *user_data);
 
 typedef struct {
     token_callback_t callback;
     void *user_data;
     bool capture_text;
+    bool capture_raw_text;
+    const simd_kernels_t *kernels;
 
     enum {
         STATE_TEXT,
@@ -32,27 +54,71 @@ typedef struct {
         STATE_END_TAG_REST,
         STATE_COMMENT_START,
         STATE_COMMENT,
-        STATE_SKIP_DECL
+        STATE_SKIP_DECL,
+        STATE_RAW_TEXT,
+        STATE_SEEK
     } state;
 
     char tag_buf[64];
     size_t tag_len;
+    uint32_t tag_hash;
+    html_tag_t tag_id;
 
-    char attrs_buf[1024];
-    size_t attrs_len;
-
-    char text_buf[2048];
-    size_t text_len;
+    /* Current text or attribute run: starts at run_start in the chunk being fed,
+     * preceded by spill_len bytes carried over from earlier chunks. */
+    bool run_active;
+    const char *run_start;
+    char *spill;
+    size_t spill_len;
+    size_t spill_cap;
 
     bool closing_tag;
     bool self_closing;
     char quote_char;
     int comment_dash_count;
+    /* Inside script, style, svg or noscript: `raw_match` bytes of the
+     * closing "</name" have been seen, possibly in an earlier chunk. */
+    html_tag_t raw_tag;
+    size_t raw_match;
+    /* Pending or active html_scanner_skip_to(); `seek_match` bytes of the
+     * current tag candidate have been seen, matching `seek_buf` while
+     * `seek_on_pattern` holds. */
+    bool seeking;
+    char seek_buf[64];
+    size_t seek_len;
+    size_t seek_match;
+    bool seek_on_pattern;
+    bool stopped;
+    html_attrs_t attr_index;
+
+    /* Plain counters, read by the owner once per document. */
+    size_t bytes_scanned;
+    size_t tokens_emitted;
 } html_scanner_t;
 
 void html_scanner_init(html_scanner_t *scanner, token_callback_t callback, void *user_data);
+void html_scanner_free(html_scanner_t *scanner);
 void html_scanner_set_capture_text(html_scanner_t *scanner, bool capture);
-void html_scanner_feed(html_scanner_t *scanner, const char *data, size_t len, bool final_chunk);
+/* The bodies of script, style, svg and noscript are not tokenized. With
+ * capture on, each body is reported as one text token; by default it is
+ * skipped. Takes effect from the next such element. */
+void html_scanner_set_capture_raw_text(html_scanner_t *scanner, bool capture);
+/*
+ * Skips ahead to the next occurrence of `pattern`, a '<' or "</" followed by
+ * a lowercase tag name, e.g. "<article". Other tags before it are not
+ * tokenized and the match is ASCII case-insensitive; scanning resumes with
+ * the matched tag, so "<article" also resumes at "<articles". The skip starts once the scanner
+ * is back in text, i.e. after the tag being reported when called from a
+ * callback. Comments, declarations and the raw text elements are still
+ * scanned while skipping, so a match inside them does not count; their start
+ * tags are reported. Returns false for an unusable pattern.
+ */
+bool html_scanner_skip_to(html_scanner_t *scanner, const char *pattern);
+/* Looks up attribute `name` (lowercase) on a start tag token. */
+bool html_token_attr(const token_t *token, const char *name, const char **value, size_t *value_len);
+bool html_token_has_class(const token_t *token, const html_class_key_t *key);
+/* Returns false once a callback has stopped the scan. */
+bool html_scanner_feed(html_scanner_t *scanner, const char *data, size_t len, bool final_chunk);
 void html_scanner_finish(html_scanner_t *scanner);
 
 #endif
@@ -0,0 +1,166 @@
+/* Generated by tools/gen_html_tags.py; do not edit. */
+#include "html_tags.h"
+
+#include <string.h>
+
+#define HTML_TAG_BUCKETS 64
+#define HTML_TAG_SLOTS 256
+
+static const char *const tag_names[HTML_TAG_COUNT] = {
+    [HTML_TAG_UNKNOWN] = "",
+#define X(id, name) [HTML_TAG_##id] = name,
+    HTML_TAG_LIST(X)
+#undef X
+};
+
+static const uint8_t tag_lengths[HTML_TAG_COUNT] = {
+#define X(id, name) [HTML_TAG_##id] = sizeof(name) - 1,
+    HTML_TAG_LIST(X)
+#undef X
+};
+
+static const uint8_t tag_disp[HTML_TAG_BUCKETS] = {
+      0,   2,   1,   0,   0,   1,   0,   0,   0,   0,   2,   0,   0,   1,   0,   0,
+      0,   4,   2,   0,   1,   0,   0,   0,   1,   1,   0,   0,   4,   0,   0,   1,
+      0,   0,   0,   0,   3,   0,   0,   0,   0,   1,   0,   3,   0,   1,   0,   5,
+      0,   0,   0,   0,   1,   1,   0,   1,   0,   0,   0,   2,   0,   0,   1,   0,
+};
+
+static const uint8_t tag_slots[HTML_TAG_SLOTS] = {
+    [2] = HTML_TAG_HTML,
+    [4] = HTML_TAG_BDO,
+    [10] = HTML_TAG_OL,
+    [12] = HTML_TAG_TBODY,
+    [13] = HTML_TAG_WBR,
+    [14] = HTML_TAG_META,
+    [16] = HTML_TAG_SOURCE,
+    [18] = HTML_TAG_SAMP,
+    [20] = HTML_TAG_TR,
+    [21] = HTML_TAG_FORM,
+    [22] = HTML_TAG_FIELDSET,
+    [23] = HTML_TAG_H1,
+    [24] = HTML_TAG_Q,
+    [25] = HTML_TAG_EM,
+    [26] = HTML_TAG_VAR,
+    [27] = HTML_TAG_COLGROUP,
+    [28] = HTML_TAG_TABLE,
+    [31] = HTML_TAG_COL,
+    [33] = HTML_TAG_DETAILS,
+    [35] = HTML_TAG_IFRAME,
+    [36] = HTML_TAG_BODY,
+    [38] = HTML_TAG_SUMMARY,
+    [39] = HTML_TAG_LEGEND,
+    [40] = HTML_TAG_MAIN,
+    [45] = HTML_TAG_TIME,
+    [47] = HTML_TAG_RT,
+    [48] = HTML_TAG_PARAM,
+    [52] = HTML_TAG_UL,
+    [54] = HTML_TAG_LABEL,
+    [56] = HTML_TAG_RP,
+    [57] = HTML_TAG_DFN,
+    [60] = HTML_TAG_P,
+    [61] = HTML_TAG_SEARCH,
+    [64] = HTML_TAG_HEAD,
+    [69] = HTML_TAG_SELECT,
+    [70] = HTML_TAG_CODE,
+    [71] = HTML_TAG_AUDIO,
+    [73] = HTML_TAG_FOOTER,
+    [74] = HTML_TAG_H5,
+    [75] = HTML_TAG_RUBY,
+    [77] = HTML_TAG_STYLE,
+    [82] = HTML_TAG_PROGRESS,
+    [83] = HTML_TAG_NAV,
+    [88] = HTML_TAG_OPTION,
+    [89] = HTML_TAG_ASIDE,
+    [95] = HTML_TAG_MAP,
+    [105] = HTML_TAG_TEMPLATE,
+    [108] = HTML_TAG_A,
+    [110] = HTML_TAG_H4,
+    [113] = HTML_TAG_BLOCKQUOTE,
+    [114] = HTML_TAG_TFOOT,
+    [116] = HTML_TAG_INS,
+    [120] = HTML_TAG_DIV,
+    [121] = HTML_TAG_AREA,
+    [124] = HTML_TAG_DATA,
+    [125] = HTML_TAG_SLOT,
+    [126] = HTML_TAG_I,
+    [127] = HTML_TAG_STRONG,
+    [130] = HTML_TAG_SPAN,
+    [132] = HTML_TAG_SUB,
+    [134] = HTML_TAG_TRACK,
+    [135] = HTML_TAG_H6,
+    [136] = HTML_TAG_U,
+    [143] = HTML_TAG_HEADER,
+    [144] = HTML_TAG_IMG,
+    [145] = HTML_TAG_H2,
+    [146] = HTML_TAG_ARTICLE,
+    [147] = HTML_TAG_SMALL,
+    [150] = HTML_TAG_OUTPUT,
+    [157] = HTML_TAG_PICTURE,
+    [164] = HTML_TAG_DIALOG,
+    [168] = HTML_TAG_DATALIST,
+    [170] = HTML_TAG_LINK,
+    [171] = HTML_TAG_EMBED,
+    [172] = HTML_TAG_INPUT,
+    [173] = HTML_TAG_DT,
+    [177] = HTML_TAG_FIGURE,
+    [178] = HTML_TAG_DEL,
+    [179] = HTML_TAG_B,
+    [180] = HTML_TAG_S,
+    [181] = HTML_TAG_METER,
+    [182] = HTML_TAG_CANVAS,
+    [183] = HTML_TAG_SCRIPT,
+    [184] = HTML_TAG_KBD,
+    [186] = HTML_TAG_FIGCAPTION,
+    [188] = HTML_TAG_MATH,
+    [189] = HTML_TAG_SVG,
+    [192] = HTML_TAG_TEXTAREA,
+    [194] = HTML_TAG_LI,
+    [196] = HTML_TAG_CAPTION,
+    [199] = HTML_TAG_BR,
+    [203] = HTML_TAG_CITE,
+    [206] = HTML_TAG_H3,
+    [207] = HTML_TAG_OPTGROUP,
+    [210] = HTML_TAG_DD,
+    [212] = HTML_TAG_ABBR,
+    [216] = HTML_TAG_HGROUP,
+    [218] = HTML_TAG_SUP,
+    [219] = HTML_TAG_THEAD,
+    [222] = HTML_TAG_TD,
+    [224] = HTML_TAG_MARK,
+    [225] = HTML_TAG_BDI,
+    [227] = HTML_TAG_TITLE,
+    [228] = HTML_TAG_OBJECT,
+    [229] = HTML_TAG_DL,
+    [231] = HTML_TAG_MENU,
+    [233] = HTML_TAG_BUTTON,
+    [236] = HTML_TAG_VIDEO,
+    [240] = HTML_TAG_BASE,
+    [241] = HTML_TAG_NOSCRIPT,
+    [246] = HTML_TAG_PRE,
+    [247] = HTML_TAG_SECTION,
+    [252] = HTML_TAG_HR,
+    [253] = HTML_TAG_ADDRESS,
+    [255] = HTML_TAG_TH,
+};
+
+html_tag_t html_tag_lookup_hashed(const char *name, size_t len, uint32_t hash) {
+    uint32_t slot = ((hash ^ tag_disp[hash % HTML_TAG_BUCKETS]) * 0x9E3779B1u) >> 24;
+    html_tag_t id = (html_tag_t)tag_slots[slot];
+    if (tag_lengths[id] != len || memcmp(tag_names[id], name, len) != 0) {
+        return HTML_TAG_UNKNOWN;
+    }
+    return id;
+}
+
+html_tag_t html_tag_lookup(const char *name, size_t len) {
+    uint32_t hash = HTML_TAG_HASH_INIT;
+    for (size_t i = 0; i < len; ++i) {
+        hash = HTML_TAG_HASH_STEP(hash, (unsigned char)name[i]);
+    }
+    return html_tag_lookup_hashed(name, len, hash);
+}
+
+const char *html_tag_name(html_tag_t id) {
+    return (unsigned)id < HTML_TAG_COUNT ? tag_names[id] : "";
+}
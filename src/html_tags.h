@@ -0,0 +1,59 @@
+#ifndef HTML_TAGS_H
+#define HTML_TAGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Known HTML element names. The lookup table in html_tags.c is a perfect hash
+ * over this list generated by tools/gen_html_tags.py; rerun it after editing.
+ */
+#define HTML_TAG_LIST(X) \
+    X(A, "a") X(ABBR, "abbr") X(ADDRESS, "address") X(AREA, "area") \
+    X(ARTICLE, "article") X(ASIDE, "aside") X(AUDIO, "audio") X(B, "b") \
+    X(BASE, "base") X(BDI, "bdi") X(BDO, "bdo") X(BLOCKQUOTE, "blockquote") \
+    X(BODY, "body") X(BR, "br") X(BUTTON, "button") X(CANVAS, "canvas") \
+    X(CAPTION, "caption") X(CITE, "cite") X(CODE, "code") X(COL, "col") \
+    X(COLGROUP, "colgroup") X(DATA, "data") X(DATALIST, "datalist") X(DD, "dd") \
+    X(DEL, "del") X(DETAILS, "details") X(DFN, "dfn") X(DIALOG, "dialog") \
+    X(DIV, "div") X(DL, "dl") X(DT, "dt") X(EM, "em") \
+    X(EMBED, "embed") X(FIELDSET, "fieldset") X(FIGCAPTION, "figcaption") X(FIGURE, "figure") \
+    X(FOOTER, "footer") X(FORM, "form") X(H1, "h1") X(H2, "h2") \
+    X(H3, "h3") X(H4, "h4") X(H5, "h5") X(H6, "h6") \
+    X(HEAD, "head") X(HEADER, "header") X(HGROUP, "hgroup") X(HR, "hr") \
+    X(HTML, "html") X(I, "i") X(IFRAME, "iframe") X(IMG, "img") \
+    X(INPUT, "input") X(INS, "ins") X(KBD, "kbd") X(LABEL, "label") \
+    X(LEGEND, "legend") X(LI, "li") X(LINK, "link") X(MAIN, "main") \
+    X(MAP, "map") X(MARK, "mark") X(MATH, "math") X(MENU, "menu") \
+    X(META, "meta") X(METER, "meter") X(NAV, "nav") X(NOSCRIPT, "noscript") \
+    X(OBJECT, "object") X(OL, "ol") X(OPTGROUP, "optgroup") X(OPTION, "option") \
+    X(OUTPUT, "output") X(P, "p") X(PARAM, "param") X(PICTURE, "picture") \
+    X(PRE, "pre") X(PROGRESS, "progress") X(Q, "q") X(RP, "rp") \
+    X(RT, "rt") X(RUBY, "ruby") X(S, "s") X(SAMP, "samp") \
+    X(SCRIPT, "script") X(SEARCH, "search") X(SECTION, "section") X(SELECT, "select") \
+    X(SLOT, "slot") X(SMALL, "small") X(SOURCE, "source") X(SPAN, "span") \
+    X(STRONG, "strong") X(STYLE, "style") X(SUB, "sub") X(SUMMARY, "summary") \
+    X(SUP, "sup") X(SVG, "svg") X(TABLE, "table") X(TBODY, "tbody") \
+    X(TD, "td") X(TEMPLATE, "template") X(TEXTAREA, "textarea") X(TFOOT, "tfoot") \
+    X(TH, "th") X(THEAD, "thead") X(TIME, "time") X(TITLE, "title") \
+    X(TR, "tr") X(TRACK, "track") X(U, "u") X(UL, "ul") \
+    X(VAR, "var") X(VIDEO, "video") X(WBR, "wbr")
+
+typedef enum {
+    HTML_TAG_UNKNOWN = 0,
+#define X(id, name) HTML_TAG_##id,
+    HTML_TAG_LIST(X)
+#undef X
+    HTML_TAG_COUNT
+} html_tag_t;
+
+/* FNV-1a over the lowercased name; the scanner folds it in as it reads. */
+#define HTML_TAG_HASH_INIT 2166136261u
+#define HTML_TAG_HASH_STEP(hash, c) (((hash) ^ (uint32_t)(c)) * 16777619u)
+
+/* `name` must be lowercase. Names outside HTML_TAG_LIST map to HTML_TAG_UNKNOWN. */
+html_tag_t html_tag_lookup(const char *name, size_t len);
+html_tag_t html_tag_lookup_hashed(const char *name, size_t len, uint32_t hash);
+const char *html_tag_name(html_tag_t id);
+
+#endif
@@ -28,84 +28,492 @@ void http_buffer_free(http_buffer_t *buffer) {
     buffer->size = 0;
 }
 
-static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
-    size_t total = size * nmemb;
-    http_buffer_t *buffer = (http_buffer_t *)userdata;
-    char *new_data = (char *)realloc(buffer->data, buffer->size + total + 1);
+bool http_buffer_append(http_buffer_t *buffer, const char *data, size_t len) {
+    char *new_data = (char *)realloc(buffer->data, buffer->size + len + 1);
     if (!new_data) {
-        return 0;
+        return false;
     }
     buffer->data = new_data;
-    memcpy(buffer->data + buffer->size, ptr, total);
-    buffer->size += total;
+    memcpy(buffer->data + buffer->size, data, len);
+    buffer->size += len;
     buffer->data[buffer->size] = '\0';
-    return total;
+    return true;
 }
 
-int http_get(const char *url, long timeout_seconds, int retries, http_buffer_t *buffer, long *status_code) {
-    if (!url || !buffer) {
+int http_client_init(http_client_t *client) {
+    client->stats = NULL;
+    client->cache = NULL;
+    client->record = NULL;
+    client->replay = NULL;
+    client->pool = NULL;
+    client->pool_len = 0;
+    client->pool_cap = 0;
+    client->share = curl_share_init();
+    if (!client->share) {
         return -1;
     }
-    CURL *curl = curl_easy_init();
+    curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    return 0;
+}
+
+void http_client_free(http_client_t *client) {
+    if (!client) {
+        return;
+    }
+    for (size_t i = 0; i < client->pool_len; ++i) {
+        curl_easy_cleanup(client->pool[i]);
+    }
+    free(client->pool);
+    client->pool = NULL;
+    client->pool_len = 0;
+    client->pool_cap = 0;
+    if (client->share) {
+        curl_share_cleanup(client->share);
+        client->share = NULL;
+    }
+}
+
+CURL *http_client_acquire(http_client_t *client) {
+    CURL *curl = NULL;
+    if (client->pool_len > 0) {
+        curl = client->pool[--client->pool_len];
+    } else {
+        curl = curl_easy_init();
+    }
+    if (curl && client->share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, client->share);
+    }
+    return curl;
+}
+
+void http_client_release(http_client_t *client, CURL *curl) {
     if (!curl) {
-        return -1;
+        return;
     }
-    const long backoff_delays[] = {200, 600, 1200};
-    int attempts = retries + 1;
-    int attempt = 0;
-    int result = -1;
+    curl_easy_reset(curl);
+    if (client->pool_len == client->pool_cap) {
+        size_t cap = client->pool_cap ? client->pool_cap * 2 : 4;
+        CURL **pool = (CURL **)realloc(client->pool, cap * sizeof(*pool));
+        if (!pool) {
+            curl_easy_cleanup(curl);
+            return;
+        }
+        client->pool = pool;
+        client->pool_cap = cap;
+    }
+    client->pool[client->pool_len++] = curl;
+}
 
-    for (attempt = 0; attempt < attempts; ++attempt) {
-        http_buffer_free(buffer);
-        http_buffer_init(buffer);
-
-        curl_easy_setopt(curl, CURLOPT_URL, url);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, buffer);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "habr-c-parser/0.1");
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, timeout_seconds);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds);
-        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
-        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 0L);
+void http_client_configure_multi(http_client_t *client, CURLM *multi, int max_connections) {
+    (void)client;
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    if (max_connections > 0) {
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)max_connections);
+    }
+}
 
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            if (attempt < retries) {
-                utils_sleep_ms(backoff_delays[attempt < 3 ? attempt : 2]);
-                continue;
+void http_client_set_cache(http_client_t *client, http_cache_t *cache) {
+    client->cache = cache;
+}
+
+void http_client_set_record(http_client_t *client, http_archive_t *archive) {
+    client->record = archive;
+}
+
+void http_client_set_replay(http_client_t *client, http_archive_t *archive) {
+    client->replay = archive;
+}
+
+void http_client_set_stats(http_client_t *client, stats_t *stats) {
+    client->stats = stats;
+}
+
+typedef struct {
+    const http_sink_t *sink;
+    http_buffer_t *tee;
+} local_sink_t;
+
+static bool local_chunk(const char *data, size_t len, void *user_data) {
+    local_sink_t *local = (local_sink_t *)user_data;
+    if (local->tee) {
+        http_buffer_append(local->tee, data, len);
+    }
+    return local->sink->chunk(data, len, local->sink->user_data);
+}
+
+static http_local_t serve_replay(http_client_t *client, const char *url, const http_sink_t *sink,
+                                 long *status_code) {
+    const http_archive_record_t *record = http_archive_find(client->replay, url);
+    if (!record) {
+        return HTTP_LOCAL_FAILED;
+    }
+    if (status_code) {
+        *status_code = record->status;
+    }
+    if (record->status >= 400) {
+        return HTTP_LOCAL_FAILED;
+    }
+    if (sink->begin) {
+        sink->begin(0, sink->user_data);
+    }
+    local_sink_t local = {sink, NULL};
+    return http_archive_read_body(client->replay, record, local_chunk, &local) == 0 ? HTTP_LOCAL_SERVED
+                                                                                   : HTTP_LOCAL_FAILED;
+}
+
+static http_local_t serve_local(http_client_t *client, const char *url, const http_sink_t *sink,
+                                long *status_code) {
+    if (client->replay) {
+        return serve_replay(client, url, sink, status_code);
+    }
+    if (!client->cache) {
+        return HTTP_LOCAL_MISS;
+    }
+    http_cache_entry_t entry;
+    if (!http_cache_lookup(client->cache, url, &entry) || !entry.fresh) {
+        return HTTP_LOCAL_MISS;
+    }
+    if (sink->begin) {
+        sink->begin(0, sink->user_data);
+    }
+    http_buffer_t tee;
+    http_buffer_init(&tee);
+    local_sink_t local = {sink, client->record ? &tee : NULL};
+    if (http_cache_read_body(&entry, local_chunk, &local) != 0) {
+        http_buffer_free(&tee);
+        return HTTP_LOCAL_FAILED;
+    }
+    if (client->record) {
+        http_archive_append(client->record, url, 200, NULL, 0, tee.data, tee.size);
+    }
+    http_buffer_free(&tee);
+    if (status_code) {
+        *status_code = 200;
+    }
+    return HTTP_LOCAL_SERVED;
+}
+
+http_local_t http_client_serve_local(http_client_t *client, const char *url, const http_sink_t *sink,
+                                     long *status_code) {
+    http_local_t local = serve_local(client, url, sink, status_code);
+    if (local == HTTP_LOCAL_SERVED && client->stats) {
+        client->stats->local_responses++;
+    }
+    return local;
+}
+
+static bool deliver(http_transfer_t *transfer, const char *data, size_t len) {
+    if (transfer->record) {
+        http_buffer_append(&transfer->record_body, data, len);
+    }
+    if (!transfer->sink_done && !transfer->sink->chunk(data, len, transfer->sink->user_data)) {
+        transfer->sink_done = true;
+    }
+    /* Once the sink has enough, the rest of the body is only read for the
+     * cache and the archive; without either, the transfer stops here. */
+    if (transfer->sink_done && !transfer->record && (!transfer->cache_body || transfer->cache_failed)) {
+        transfer->stopped = true;
+        return false;
+    }
+    return true;
+}
+
+static void copy_header_value(const char *value, size_t len, char *out, size_t cap) {
+    while (len > 0 && (*value == ' ' || *value == '\t')) {
+        ++value;
+        --len;
+    }
+    while (len > 0 && (value[len - 1] == '\r' || value[len - 1] == '\n' || value[len - 1] == ' ')) {
+        --len;
+    }
+    if (len >= cap) {
+        len = cap - 1;
+    }
+    memcpy(out, value, len);
+    out[len] = '\0';
+}
+
+static size_t header_callback(char *buffer, size_t size, size_t nitems, void *userdata) {
+    size_t total = size * nitems;
+    http_transfer_t *transfer = (http_transfer_t *)userdata;
+    if (total >= 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        transfer->etag[0] = '\0';
+        transfer->last_modified[0] = '\0';
+        transfer->record_headers.size = 0;
+    }
+    if (transfer->record) {
+        http_buffer_append(&transfer->record_headers, buffer, total);
+    }
+    const char *colon = (const char *)memchr(buffer, ':', total);
+    if (!colon) {
+        return total;
+    }
+    size_t name_len = (size_t)(colon - buffer);
+    const char *value = colon + 1;
+    size_t value_len = total - name_len - 1;
+    if (name_len == 4 && utils_strncasecmp_local(buffer, "etag", 4) == 0) {
+        copy_header_value(value, value_len, transfer->etag, sizeof(transfer->etag));
+    } else if (name_len == 13 && utils_strncasecmp_local(buffer, "last-modified", 13) == 0) {
+        copy_header_value(value, value_len, transfer->last_modified, sizeof(transfer->last_modified));
+    }
+    return total;
+}
+
+static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    size_t total = size * nmemb;
+    http_transfer_t *transfer = (http_transfer_t *)userdata;
+    if (!transfer->status_checked) {
+        long code = 0;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &code);
+        transfer->deliver = code < 400;
+        transfer->status_checked = true;
+        if (transfer->cache && code == 200) {
+            transfer->cache_body = http_cache_begin_store(&transfer->cache_entry);
+        }
+    }
+    if (!transfer->deliver || total == 0) {
+        return total;
+    }
+    if (transfer->cache_body && !transfer->cache_failed) {
+        if (fwrite(ptr, 1, total, transfer->cache_body) != total) {
+            transfer->cache_failed = true;
+        }
+    }
+    return deliver(transfer, ptr, total) ? total : 0;
+}
+
+void http_transfer_prepare(http_transfer_t *transfer, http_client_t *client, CURL *curl, const char *url,
+                           long timeout_seconds, const http_sink_t *sink) {
+    transfer->curl = curl;
+    transfer->sink = sink;
+    transfer->url = url;
+    transfer->status_checked = false;
+    transfer->deliver = false;
+    transfer->stopped = false;
+    transfer->sink_done = false;
+    transfer->response_code = 0;
+    transfer->cache = client->cache;
+    transfer->cache_body = NULL;
+    transfer->cache_failed = false;
+    transfer->headers = NULL;
+    transfer->etag[0] = '\0';
+    transfer->last_modified[0] = '\0';
+    transfer->record = client->record;
+    transfer->stats = client->stats;
+    http_buffer_init(&transfer->record_headers);
+    http_buffer_init(&transfer->record_body);
+
+    if (transfer->cache) {
+        char header[HTTP_CACHE_VALIDATOR_CAP + 32];
+        if (http_cache_lookup(transfer->cache, url, &transfer->cache_entry)) {
+            if (transfer->cache_entry.etag[0] != '\0') {
+                snprintf(header, sizeof(header), "If-None-Match: %s", transfer->cache_entry.etag);
+                transfer->headers = curl_slist_append(transfer->headers, header);
+            }
+            if (transfer->cache_entry.last_modified[0] != '\0') {
+                snprintf(header, sizeof(header), "If-Modified-Since: %s", transfer->cache_entry.last_modified);
+                transfer->headers = curl_slist_append(transfer->headers, header);
             }
-            break;
         }
+    }
+    if (transfer->cache || transfer->record) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer);
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
 
-        long code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "habr-c-parser/0.1");
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, timeout_seconds);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 0L);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+}
+
+http_result_t http_transfer_result(http_transfer_t *transfer, CURLcode res, long *status_code) {
+    long code = 0;
+    curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &code);
+    transfer->response_code = code;
+    if (transfer->stopped) {
         if (status_code) {
             *status_code = code;
         }
-        if (code == 429 || code >= 500) {
-            if (attempt < retries) {
-                utils_sleep_ms(backoff_delays[attempt < 3 ? attempt : 2]);
-                continue;
-            }
-            break;
+        return HTTP_RESULT_OK;
+    }
+    if (res != CURLE_OK) {
+        return HTTP_RESULT_RETRY;
+    }
+    if (status_code) {
+        *status_code = code;
+    }
+    if (code == 429 || code >= 500) {
+        return HTTP_RESULT_RETRY;
+    }
+    if (code >= 400) {
+        return HTTP_RESULT_FAILED;
+    }
+    return HTTP_RESULT_OK;
+}
+
+static bool forward_cached(const char *data, size_t len, void *user_data) {
+    return deliver((http_transfer_t *)user_data, data, len);
+}
+
+static void record_stats(http_transfer_t *transfer, bool ok) {
+    curl_off_t total_us = 0;
+    curl_off_t downloaded = 0;
+    curl_easy_getinfo(transfer->curl, CURLINFO_TOTAL_TIME_T, &total_us);
+    curl_easy_getinfo(transfer->curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    transfer->stats->http_requests++;
+    transfer->stats->http_bytes += (unsigned long long)downloaded;
+    if (transfer->stopped) {
+        transfer->stats->http_cancelled++;
+    } else if (!ok) {
+        transfer->stats->http_failures++;
+    }
+    stats_record_latency(transfer->stats, (double)total_us / 1000.0);
+}
+
+void http_transfer_complete(http_transfer_t *transfer, http_result_t outcome) {
+    bool ok = outcome == HTTP_RESULT_OK;
+    if (transfer->stats) {
+        record_stats(transfer, ok);
+    }
+    if (transfer->cache_body) {
+        if (ok && !transfer->stopped && !transfer->cache_failed && transfer->response_code == 200) {
+            http_cache_commit_store(&transfer->cache_entry, transfer->cache_body, transfer->url, transfer->etag,
+                                    transfer->last_modified);
+        } else {
+            http_cache_abort_store(&transfer->cache_entry, transfer->cache_body);
         }
-        if (code >= 400) {
-            break;
+        transfer->cache_body = NULL;
+    } else if (ok && !transfer->stopped && transfer->response_code == 304 && transfer->cache_entry.found) {
+        if (transfer->etag[0] != '\0') {
+            utils_copy_string(transfer->cache_entry.etag, sizeof(transfer->cache_entry.etag), transfer->etag);
         }
-        if (!buffer->data) {
-            buffer->data = (char *)malloc(1);
-            if (!buffer->data) {
-                break;
-            }
-            buffer->data[0] = '\0';
+        if (transfer->last_modified[0] != '\0') {
+            utils_copy_string(transfer->cache_entry.last_modified, sizeof(transfer->cache_entry.last_modified),
+                              transfer->last_modified);
+        }
+        http_cache_read_body(&transfer->cache_entry, forward_cached, transfer);
+        http_cache_touch(&transfer->cache_entry, transfer->url);
+    }
+    if (transfer->record && !transfer->stopped && (ok || transfer->response_code >= 400)) {
+        long status = transfer->response_code == 304 ? 200 : transfer->response_code;
+        http_archive_append(transfer->record, transfer->url, status, transfer->record_headers.data,
+                            transfer->record_headers.size, transfer->record_body.data, transfer->record_body.size);
+    }
+    http_buffer_free(&transfer->record_headers);
+    http_buffer_free(&transfer->record_body);
+    if (transfer->headers) {
+        curl_easy_setopt(transfer->curl, CURLOPT_HTTPHEADER, NULL);
+        curl_slist_free_all(transfer->headers);
+        transfer->headers = NULL;
+    }
+}
+
+void http_transfer_abort(http_transfer_t *transfer) {
+    transfer->stopped = true;
+    http_transfer_complete(transfer, HTTP_RESULT_OK);
+}
+
+long http_backoff_ms(int attempt) {
+    static const long backoff_delays[] = {200, 600, 1200};
+    return backoff_delays[attempt < 3 ? attempt : 2];
+}
+
+int http_get_stream(http_client_t *client, const char *url, long timeout_seconds, int retries,
+                    const http_sink_t *sink, long *status_code) {
+    if (!client || !url || !sink || !sink->chunk) {
+        return -1;
+    }
+    http_local_t local = http_client_serve_local(client, url, sink, status_code);
+    if (local != HTTP_LOCAL_MISS) {
+        return local == HTTP_LOCAL_SERVED ? 0 : -1;
+    }
+    CURL *curl = http_client_acquire(client);
+    if (!curl) {
+        return -1;
+    }
+    int attempts = retries + 1;
+    int result = -1;
+
+    http_transfer_t transfer;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        if (sink->begin) {
+            sink->begin(attempt, sink->user_data);
+        }
+        http_transfer_prepare(&transfer, client, curl, url, timeout_seconds, sink);
+        CURLcode res = curl_easy_perform(curl);
+        http_result_t outcome = http_transfer_result(&transfer, res, status_code);
+        http_transfer_complete(&transfer, outcome);
+        if (outcome == HTTP_RESULT_RETRY && attempt < retries) {
+            stats_record_retry(client->stats, http_backoff_ms(attempt));
+            utils_sleep_ms(http_backoff_ms(attempt));
+            continue;
+        }
+        if (outcome == HTTP_RESULT_OK) {
+            result = 0;
         }
-        result = 0;
         break;
     }
 
-    curl_easy_cleanup(curl);
+    http_client_release(client, curl);
     return result;
 }
 
+typedef struct {
+    http_buffer_t *buffer;
+    bool out_of_memory;
+} buffer_sink_t;
+
+static void buffer_begin(int attempt, void *user_data) {
+    (void)attempt;
+    buffer_sink_t *ctx = (buffer_sink_t *)user_data;
+    http_buffer_free(ctx->buffer);
+    http_buffer_init(ctx->buffer);
+    ctx->out_of_memory = false;
+}
+
+static bool buffer_chunk(const char *data, size_t len, void *user_data) {
+    buffer_sink_t *ctx = (buffer_sink_t *)user_data;
+    if (!http_buffer_append(ctx->buffer, data, len)) {
+        ctx->out_of_memory = true;
+        return false;
+    }
+    return true;
+}
+
+int http_get(http_client_t *client, const char *url, long timeout_seconds, int retries, http_buffer_t *buffer,
+             long *status_code) {
+    if (!url || !buffer) {
+        return -1;
+    }
+    buffer_sink_t ctx;
+    ctx.buffer = buffer;
+    ctx.out_of_memory = false;
+    http_sink_t sink;
+    sink.begin = buffer_begin;
+    sink.chunk = buffer_chunk;
+    sink.user_data = &ctx;
+    if (http_get_stream(client, url, timeout_seconds, retries, &sink, status_code) != 0 || ctx.out_of_memory) {
+        return -1;
+    }
+    if (!buffer->data) {
+        buffer->data = (char *)malloc(1);
+        if (!buffer->data) {
+            return -1;
+        }
+        buffer->data[0] = '\0';
+    }
+    return 0;
+}
@@ -1,17 +1,114 @@
 #ifndef HTTP_H
 #define HTTP_H
 
+#include <curl/curl.h>
 #include <stddef.h>
+#include <stdbool.h>
+
+#include "http_archive.h"
+#include "http_cache.h"
+#include "stats.h"
 
 typedef struct {
     char *data;
     size_t size;
 } http_buffer_t;
 
+/* `attempt` is 0 for the first try and counts up on every retry. */
+typedef void (*http_begin_callback_t)(int attempt, void *user_data);
+/*
+ * Returning false means the sink has enough: nothing more is delivered and the
+ * request counts as successful. The transfer stops unless the rest of the body
+ * is still needed for the cache or the record archive.
+ */
+typedef bool (*http_chunk_callback_t)(const char *data, size_t len, void *user_data);
+
+typedef struct {
+    http_begin_callback_t begin;
+    http_chunk_callback_t chunk;
+    void *user_data;
+} http_sink_t;
+
+/* State of one request attempt, shared by the blocking and the multi paths. */
+typedef struct {
+    CURL *curl;
+    const http_sink_t *sink;
+    const char *url;
+    bool status_checked;
+    bool deliver;
+    bool stopped;
+    bool sink_done;
+    long response_code;
+
+    http_cache_t *cache;
+    http_cache_entry_t cache_entry;
+    FILE *cache_body;
+    bool cache_failed;
+    struct curl_slist *headers;
+    char etag[HTTP_CACHE_VALIDATOR_CAP];
+    char last_modified[HTTP_CACHE_VALIDATOR_CAP];
+
+    http_archive_t *record;
+    http_buffer_t record_headers;
+    http_buffer_t record_body;
+
+    stats_t *stats;
+} http_transfer_t;
+
+typedef enum {
+    HTTP_RESULT_OK,
+    HTTP_RESULT_RETRY,
+    HTTP_RESULT_FAILED
+} http_result_t;
+
+typedef enum {
+    HTTP_LOCAL_MISS,
+    HTTP_LOCAL_SERVED,
+    HTTP_LOCAL_FAILED
+} http_local_t;
+
+/*
+ * Long-lived client: pooled easy handles sharing one DNS cache, TLS session
+ * cache and connection cache, so consecutive requests to the same host skip
+ * the lookup and the handshake. Not thread-safe.
+ */
+typedef struct {
+    CURLSH *share;
+    CURL **pool;
+    size_t pool_len;
+    size_t pool_cap;
+    http_cache_t *cache;
+    http_archive_t *record;
+    http_archive_t *replay;
+    stats_t *stats;
+} http_client_t;
+
 int http_init(void);
 void http_cleanup(void);
 void http_buffer_init(http_buffer_t *buffer);
 void http_buffer_free(http_buffer_t *buffer);
-int http_get(const char *url, long timeout_seconds, int retries, http_buffer_t *buffer, long *status_code);
+bool http_buffer_append(http_buffer_t *buffer, const char *data, size_t len);
+int http_client_init(http_client_t *client);
+void http_client_free(http_client_t *client);
+CURL *http_client_acquire(http_client_t *client);
+void http_client_release(http_client_t *client, CURL *curl);
+void http_client_configure_multi(http_client_t *client, CURLM *multi, int max_connections);
+void http_client_set_cache(http_client_t *client, http_cache_t *cache);
+void http_client_set_record(http_client_t *client, http_archive_t *archive);
+void http_client_set_replay(http_client_t *client, http_archive_t *archive);
+void http_client_set_stats(http_client_t *client, stats_t *stats);
+http_local_t http_client_serve_local(http_client_t *client, const char *url, const http_sink_t *sink,
+                                     long *status_code);
+int http_get(http_client_t *client, const char *url, long timeout_seconds, int retries, http_buffer_t *buffer,
+             long *status_code);
+int http_get_stream(http_client_t *client, const char *url, long timeout_seconds, int retries,
+                    const http_sink_t *sink, long *status_code);
+void http_transfer_prepare(http_transfer_t *transfer, http_client_t *client, CURL *curl, const char *url,
+                           long timeout_seconds, const http_sink_t *sink);
+http_result_t http_transfer_result(http_transfer_t *transfer, CURLcode res, long *status_code);
+void http_transfer_complete(http_transfer_t *transfer, http_result_t outcome);
+/* Releases a transfer that is no longer needed; nothing is cached or recorded. */
+void http_transfer_abort(http_transfer_t *transfer);
+long http_backoff_ms(int attempt);
 
 #endif
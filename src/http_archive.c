@@ -0,0 +1,223 @@
+#include "http_archive.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HABR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define HTTP_ARCHIVE_MAGIC "HABR-ARCHIVE/1"
+
+bool http_archive_compression_available(void) {
+#ifdef HABR_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void reset(http_archive_t *archive) {
+    archive->file = NULL;
+    archive->compress = false;
+    archive->records = NULL;
+    archive->count = 0;
+    archive->cap = 0;
+}
+
+int http_archive_open_record(http_archive_t *archive, const char *path, bool compress) {
+    reset(archive);
+    if (compress && !http_archive_compression_available()) {
+        fprintf(stderr, "Archive compression requires zlib support\n");
+        return -1;
+    }
+    archive->file = fopen(path, "ab");
+    if (!archive->file) {
+        fprintf(stderr, "Failed to open archive %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    archive->compress = compress;
+    return 0;
+}
+
+static void strip_newline(char *line) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+}
+
+static bool add_record(http_archive_t *archive, const http_archive_record_t *record) {
+    if (archive->count == archive->cap) {
+        size_t cap = archive->cap ? archive->cap * 2 : 16;
+        http_archive_record_t *records =
+            (http_archive_record_t *)realloc(archive->records, cap * sizeof(*records));
+        if (!records) {
+            return false;
+        }
+        archive->records = records;
+        archive->cap = cap;
+    }
+    archive->records[archive->count++] = *record;
+    return true;
+}
+
+int http_archive_open_replay(http_archive_t *archive, const char *path) {
+    reset(archive);
+    archive->file = fopen(path, "rb");
+    if (!archive->file) {
+        fprintf(stderr, "Failed to open archive %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[8192];
+    while (fgets(line, sizeof(line), archive->file)) {
+        strip_newline(line);
+        if (line[0] == '\0') {
+            continue;
+        }
+        if (strcmp(line, HTTP_ARCHIVE_MAGIC) != 0) {
+            fprintf(stderr, "Corrupt archive %s: unexpected record header\n", path);
+            http_archive_close(archive);
+            return -1;
+        }
+        http_archive_record_t record;
+        memset(&record, 0, sizeof(record));
+        while (fgets(line, sizeof(line), archive->file)) {
+            strip_newline(line);
+            if (line[0] == '\0') {
+                break;
+            }
+            if (strncmp(line, "URL: ", 5) == 0) {
+                free(record.url);
+                size_t len = strlen(line + 5);
+                record.url = (char *)malloc(len + 1);
+                if (record.url) {
+                    memcpy(record.url, line + 5, len + 1);
+                }
+            } else if (strncmp(line, "Status: ", 8) == 0) {
+                record.status = strtol(line + 8, NULL, 10);
+            } else if (strncmp(line, "Content-Encoding: ", 18) == 0) {
+                record.compressed = strcmp(line + 18, "deflate") == 0;
+            } else if (strncmp(line, "Header-Length: ", 15) == 0) {
+                record.header_len = (size_t)strtoull(line + 15, NULL, 10);
+            } else if (strncmp(line, "Content-Length: ", 16) == 0) {
+                record.stored_len = (size_t)strtoull(line + 16, NULL, 10);
+            } else if (strncmp(line, "Original-Length: ", 17) == 0) {
+                record.body_len = (size_t)strtoull(line + 17, NULL, 10);
+            }
+        }
+        record.payload_offset = ftell(archive->file);
+        if (!record.url || record.payload_offset < 0 ||
+            fseek(archive->file, (long)(record.header_len + record.stored_len), SEEK_CUR) != 0 ||
+            !add_record(archive, &record)) {
+            free(record.url);
+            fprintf(stderr, "Corrupt archive %s: truncated record\n", path);
+            http_archive_close(archive);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void http_archive_close(http_archive_t *archive) {
+    if (!archive) {
+        return;
+    }
+    if (archive->file) {
+        fclose(archive->file);
+    }
+    for (size_t i = 0; i < archive->count; ++i) {
+        free(archive->records[i].url);
+    }
+    free(archive->records);
+    reset(archive);
+}
+
+int http_archive_append(http_archive_t *archive, const char *url, long status, const char *headers,
+                        size_t headers_len, const char *body, size_t body_len) {
+    if (!archive->file) {
+        return -1;
+    }
+    const char *stored = body;
+    size_t stored_len = body_len;
+    const char *encoding = "identity";
+#ifdef HABR_HAVE_ZLIB
+    unsigned char *compressed = NULL;
+    if (archive->compress) {
+        uLongf bound = compressBound((uLong)body_len);
+        compressed = (unsigned char *)malloc(bound);
+        if (compressed && compress2(compressed, &bound, (const Bytef *)body, (uLong)body_len, 6) == Z_OK) {
+            stored = (const char *)compressed;
+            stored_len = (size_t)bound;
+            encoding = "deflate";
+        }
+    }
+#endif
+    fprintf(archive->file,
+            "%s\r\nURL: %s\r\nStatus: %ld\r\nDate: %lld\r\nContent-Encoding: %s\r\n"
+            "Header-Length: %zu\r\nContent-Length: %zu\r\nOriginal-Length: %zu\r\n\r\n",
+            HTTP_ARCHIVE_MAGIC, url, status, (long long)time(NULL), encoding, headers_len, stored_len, body_len);
+    if (headers_len > 0) {
+        fwrite(headers, 1, headers_len, archive->file);
+    }
+    if (stored_len > 0) {
+        fwrite(stored, 1, stored_len, archive->file);
+    }
+    fputs("\r\n\r\n", archive->file);
+#ifdef HABR_HAVE_ZLIB
+    free(compressed);
+#endif
+    return fflush(archive->file) == 0 && !ferror(archive->file) ? 0 : -1;
+}
+
+const http_archive_record_t *http_archive_find(const http_archive_t *archive, const char *url) {
+    for (size_t i = archive->count; i > 0; --i) {
+        if (strcmp(archive->records[i - 1].url, url) == 0) {
+            return &archive->records[i - 1];
+        }
+    }
+    return NULL;
+}
+
+int http_archive_read_body(const http_archive_t *archive, const http_archive_record_t *record,
+                           http_archive_chunk_callback_t chunk, void *user_data) {
+    if (fseek(archive->file, record->payload_offset + (long)record->header_len, SEEK_SET) != 0) {
+        return -1;
+    }
+    if (record->compressed) {
+#ifdef HABR_HAVE_ZLIB
+        unsigned char *stored = (unsigned char *)malloc(record->stored_len ? record->stored_len : 1);
+        char *body = (char *)malloc(record->body_len ? record->body_len : 1);
+        int result = -1;
+        uLongf body_len = (uLongf)record->body_len;
+        if (stored && body && fread(stored, 1, record->stored_len, archive->file) == record->stored_len &&
+            uncompress((Bytef *)body, &body_len, stored, (uLong)record->stored_len) == Z_OK) {
+            if (body_len > 0) {
+                chunk(body, (size_t)body_len, user_data);
+            }
+            result = 0;
+        }
+        free(stored);
+        free(body);
+        return result;
+#else
+        return -1;
+#endif
+    }
+    char buffer[65536];
+    size_t remaining = record->stored_len;
+    while (remaining > 0) {
+        size_t want = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        size_t n = fread(buffer, 1, want, archive->file);
+        if (n == 0) {
+            return -1;
+        }
+        remaining -= n;
+        if (!chunk(buffer, n, user_data)) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef HTTP_ARCHIVE_H
+#define HTTP_ARCHIVE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Append-only archive of HTTP responses, loosely modelled on WARC. Each record
+ * is a text header block followed by the raw response headers and the body:
+ *
+ *   HABR-ARCHIVE/1
+ *   URL: <url>
+ *   Status: <code>
+ *   Date: <unix seconds>
+ *   Content-Encoding: identity|deflate
+ *   Header-Length: <bytes of response headers>
+ *   Content-Length: <bytes of stored body>
+ *   Original-Length: <bytes of body after decoding>
+ *   <empty line>
+ *   <response headers><stored body>
+ *   <empty line>
+ *
+ * Opening an archive for replay builds an in-memory index of all records by
+ * reading the header blocks and seeking over the payloads.
+ */
+typedef struct {
+    char *url;
+    long status;
+    long payload_offset;
+    size_t header_len;
+    size_t stored_len;
+    size_t body_len;
+    bool compressed;
+} http_archive_record_t;
+
+typedef struct {
+    FILE *file;
+    bool compress;
+    http_archive_record_t *records;
+    size_t count;
+    size_t cap;
+} http_archive_t;
+
+typedef bool (*http_archive_chunk_callback_t)(const char *data, size_t len, void *user_data);
+
+int http_archive_open_record(http_archive_t *archive, const char *path, bool compress);
+int http_archive_open_replay(http_archive_t *archive, const char *path);
+void http_archive_close(http_archive_t *archive);
+int http_archive_append(http_archive_t *archive, const char *url, long status, const char *headers,
+                        size_t headers_len, const char *body, size_t body_len);
+const http_archive_record_t *http_archive_find(const http_archive_t *archive, const char *url);
+int http_archive_read_body(const http_archive_t *archive, const http_archive_record_t *record,
+                           http_archive_chunk_callback_t chunk, void *user_data);
+bool http_archive_compression_available(void);
+
+#endif
@@ -0,0 +1,186 @@
+#include "http_cache.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "utils.h"
+
+#define HTTP_CACHE_MAGIC "HABR-CACHE 1"
+
+static unsigned long long fnv1a64(const char *str) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)str; *p; ++p) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int make_dir(const char *dir) {
+#ifdef _WIN32
+    if (_mkdir(dir) == 0 || errno == EEXIST) {
+        return 0;
+    }
+#else
+    if (mkdir(dir, 0755) == 0 || errno == EEXIST) {
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+static int replace_file(const char *from, const char *to) {
+#ifdef _WIN32
+    remove(to);
+#endif
+    return rename(from, to) == 0 ? 0 : -1;
+}
+
+int http_cache_init(http_cache_t *cache, const char *dir, long ttl_seconds) {
+    if (!cache || !dir || !utils_copy_string(cache->dir, sizeof(cache->dir), dir)) {
+        return -1;
+    }
+    cache->ttl_seconds = ttl_seconds;
+    if (make_dir(dir) != 0) {
+        fprintf(stderr, "Failed to create cache directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void strip_newline(char *line) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+}
+
+bool http_cache_lookup(const http_cache_t *cache, const char *url, http_cache_entry_t *entry) {
+    memset(entry, 0, sizeof(*entry));
+    unsigned long long key = fnv1a64(url);
+    snprintf(entry->meta_path, sizeof(entry->meta_path), "%s/%016llx.meta", cache->dir, key);
+    snprintf(entry->body_path, sizeof(entry->body_path), "%s/%016llx.body", cache->dir, key);
+
+    FILE *meta = fopen(entry->meta_path, "rb");
+    if (!meta) {
+        return false;
+    }
+    char line[4096];
+    bool url_matches = false;
+    bool valid = fgets(line, sizeof(line), meta) != NULL;
+    if (valid) {
+        strip_newline(line);
+        valid = strcmp(line, HTTP_CACHE_MAGIC) == 0;
+    }
+    while (valid && fgets(line, sizeof(line), meta)) {
+        strip_newline(line);
+        if (strncmp(line, "url ", 4) == 0) {
+            url_matches = strcmp(line + 4, url) == 0;
+        } else if (strncmp(line, "stored ", 7) == 0) {
+            entry->stored_at = strtoll(line + 7, NULL, 10);
+        } else if (strncmp(line, "etag ", 5) == 0) {
+            utils_copy_string(entry->etag, sizeof(entry->etag), line + 5);
+        } else if (strncmp(line, "last-modified ", 14) == 0) {
+            utils_copy_string(entry->last_modified, sizeof(entry->last_modified), line + 14);
+        }
+    }
+    fclose(meta);
+    if (!valid || !url_matches) {
+        entry->etag[0] = '\0';
+        entry->last_modified[0] = '\0';
+        return false;
+    }
+    FILE *body = fopen(entry->body_path, "rb");
+    if (!body) {
+        return false;
+    }
+    fclose(body);
+    entry->found = true;
+    long long age = (long long)time(NULL) - entry->stored_at;
+    entry->fresh = age >= 0 && age < cache->ttl_seconds;
+    return true;
+}
+
+int http_cache_read_body(const http_cache_entry_t *entry, http_cache_chunk_callback_t chunk, void *user_data) {
+    FILE *body = fopen(entry->body_path, "rb");
+    if (!body) {
+        return -1;
+    }
+    char buffer[65536];
+    size_t n;
+    int result = 0;
+    while ((n = fread(buffer, 1, sizeof(buffer), body)) > 0) {
+        if (!chunk(buffer, n, user_data)) {
+            break;
+        }
+    }
+    if (ferror(body)) {
+        result = -1;
+    }
+    fclose(body);
+    return result;
+}
+
+FILE *http_cache_begin_store(const http_cache_entry_t *entry) {
+    char tmp_path[HTTP_CACHE_FILE_CAP + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", entry->body_path);
+    return fopen(tmp_path, "wb");
+}
+
+static int write_meta(const http_cache_entry_t *entry, const char *url, const char *etag,
+                      const char *last_modified) {
+    char tmp_path[HTTP_CACHE_FILE_CAP + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", entry->meta_path);
+    FILE *meta = fopen(tmp_path, "wb");
+    if (!meta) {
+        return -1;
+    }
+    fprintf(meta, "%s\nurl %s\nstored %lld\n", HTTP_CACHE_MAGIC, url, (long long)time(NULL));
+    if (etag && etag[0] != '\0') {
+        fprintf(meta, "etag %s\n", etag);
+    }
+    if (last_modified && last_modified[0] != '\0') {
+        fprintf(meta, "last-modified %s\n", last_modified);
+    }
+    if (fclose(meta) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return replace_file(tmp_path, entry->meta_path);
+}
+
+int http_cache_commit_store(const http_cache_entry_t *entry, FILE *body, const char *url, const char *etag,
+                            const char *last_modified) {
+    char tmp_path[HTTP_CACHE_FILE_CAP + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", entry->body_path);
+    if (fclose(body) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    if (replace_file(tmp_path, entry->body_path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return write_meta(entry, url, etag, last_modified);
+}
+
+void http_cache_abort_store(const http_cache_entry_t *entry, FILE *body) {
+    char tmp_path[HTTP_CACHE_FILE_CAP + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", entry->body_path);
+    if (body) {
+        fclose(body);
+    }
+    remove(tmp_path);
+}
+
+int http_cache_touch(const http_cache_entry_t *entry, const char *url) {
+    return write_meta(entry, url, entry->etag, entry->last_modified);
+}
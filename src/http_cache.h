@@ -0,0 +1,43 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define HTTP_CACHE_PATH_CAP 1024
+#define HTTP_CACHE_FILE_CAP (HTTP_CACHE_PATH_CAP + 32)
+#define HTTP_CACHE_VALIDATOR_CAP 256
+
+/*
+ * On-disk response cache. Every URL maps to <dir>/<fnv64 of URL>.meta holding
+ * the URL, the store time and the validators, next to a .body file with the
+ * raw response body. Both files are replaced atomically via rename.
+ */
+typedef struct {
+    char dir[HTTP_CACHE_PATH_CAP];
+    long ttl_seconds;
+} http_cache_t;
+
+typedef struct {
+    bool found;
+    bool fresh;
+    long long stored_at;
+    char etag[HTTP_CACHE_VALIDATOR_CAP];
+    char last_modified[HTTP_CACHE_VALIDATOR_CAP];
+    char meta_path[HTTP_CACHE_FILE_CAP];
+    char body_path[HTTP_CACHE_FILE_CAP];
+} http_cache_entry_t;
+
+typedef bool (*http_cache_chunk_callback_t)(const char *data, size_t len, void *user_data);
+
+int http_cache_init(http_cache_t *cache, const char *dir, long ttl_seconds);
+bool http_cache_lookup(const http_cache_t *cache, const char *url, http_cache_entry_t *entry);
+int http_cache_read_body(const http_cache_entry_t *entry, http_cache_chunk_callback_t chunk, void *user_data);
+FILE *http_cache_begin_store(const http_cache_entry_t *entry);
+int http_cache_commit_store(const http_cache_entry_t *entry, FILE *body, const char *url, const char *etag,
+                            const char *last_modified);
+void http_cache_abort_store(const http_cache_entry_t *entry, FILE *body);
+int http_cache_touch(const http_cache_entry_t *entry, const char *url);
+
+#endif
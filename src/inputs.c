@@ -0,0 +1,173 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "inputs.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#endif
+
+#include "utils.h"
+
+void inputs_init(inputs_t *inputs) {
+    inputs->paths = NULL;
+    inputs->len = 0;
+    inputs->cap = 0;
+}
+
+void inputs_free(inputs_t *inputs) {
+    for (size_t i = 0; i < inputs->len; ++i) {
+        free(inputs->paths[i]);
+    }
+    free(inputs->paths);
+    inputs_init(inputs);
+}
+
+static bool add_path(inputs_t *inputs, const char *path) {
+    if (inputs->len == inputs->cap) {
+        size_t cap = inputs->cap ? inputs->cap * 2 : 16;
+        char **grown = (char **)realloc(inputs->paths, cap * sizeof(char *));
+        if (!grown) {
+            return false;
+        }
+        inputs->paths = grown;
+        inputs->cap = cap;
+    }
+    size_t len = strlen(path);
+    char *copy = (char *)malloc(len + 1);
+    if (!copy) {
+        return false;
+    }
+    memcpy(copy, path, len + 1);
+    inputs->paths[inputs->len++] = copy;
+    return true;
+}
+
+#ifndef _WIN32
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool add_directory(inputs_t *inputs, const char *path) {
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    inputs_t names;
+    inputs_init(&names);
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            ok = add_path(&names, entry->d_name);
+        }
+    }
+    closedir(dir);
+    if (names.len > 0) {
+        qsort(names.paths, names.len, sizeof(char *), compare_names);
+    }
+    size_t path_len = strlen(path);
+    for (size_t i = 0; ok && i < names.len; ++i) {
+        size_t name_len = strlen(names.paths[i]);
+        char *child = (char *)malloc(path_len + name_len + 2);
+        if (!child) {
+            ok = false;
+            break;
+        }
+        memcpy(child, path, path_len);
+        size_t pos = path_len;
+        if (pos == 0 || child[pos - 1] != '/') {
+            child[pos++] = '/';
+        }
+        memcpy(child + pos, names.paths[i], name_len + 1);
+        /* Symlinked directories are skipped, so link cycles cannot recurse
+         * forever; symlinked files are still read. */
+        struct stat st;
+        if (lstat(child, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                ok = add_directory(inputs, child);
+            } else if (S_ISREG(st.st_mode) ||
+                       (S_ISLNK(st.st_mode) && stat(child, &st) == 0 && S_ISREG(st.st_mode))) {
+                ok = add_path(inputs, child);
+            }
+        }
+        free(child);
+    }
+    inputs_free(&names);
+    return ok;
+}
+
+static bool add_glob(inputs_t *inputs, const char *pattern) {
+    glob_t matches;
+    int rc = glob(pattern, 0, NULL, &matches);
+    if (rc == GLOB_NOMATCH) {
+        fprintf(stderr, "No files match %s\n", pattern);
+        return false;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "Failed to expand %s\n", pattern);
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < matches.gl_pathc; ++i) {
+        struct stat st;
+        if (stat(matches.gl_pathv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            ok = add_directory(inputs, matches.gl_pathv[i]);
+        } else {
+            ok = add_path(inputs, matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+    return ok;
+}
+#endif
+
+static bool add_spec(inputs_t *inputs, const char *spec) {
+#ifndef _WIN32
+    if (strpbrk(spec, "*?[")) {
+        return add_glob(inputs, spec);
+    }
+    struct stat st;
+    if (stat(spec, &st) == 0 && S_ISDIR(st.st_mode)) {
+        return add_directory(inputs, spec);
+    }
+#endif
+    return add_path(inputs, spec);
+}
+
+static bool add_list(inputs_t *inputs, const char *path) {
+    char *data = NULL;
+    if (utils_read_file(path, &data, NULL) != 0) {
+        return false;
+    }
+    bool ok = true;
+    char *line = data;
+    while (ok && *line) {
+        char *end = line + strcspn(line, "\r\n");
+        char next = *end;
+        *end = '\0';
+        if (*line) {
+            ok = add_spec(inputs, line);
+        }
+        line = next ? end + 1 : end;
+    }
+    free(data);
+    return ok;
+}
+
+bool inputs_add(inputs_t *inputs, const char *spec) {
+    if (spec[0] == '@') {
+        return add_list(inputs, spec + 1);
+    }
+    return add_spec(inputs, spec);
+}
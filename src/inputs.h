@@ -0,0 +1,24 @@
+#ifndef INPUTS_H
+#define INPUTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Input files for fixture mode, in the order they were given. */
+typedef struct {
+    char **paths;
+    size_t len;
+    size_t cap;
+} inputs_t;
+
+void inputs_init(inputs_t *inputs);
+void inputs_free(inputs_t *inputs);
+/*
+ * Adds the files `spec` names: a file, a directory (every file below it,
+ * sorted by name), a glob pattern, or `@LIST` for a file listing one file,
+ * directory or glob per line. Lists do not nest: a line starting with '@'
+ * names a file. Errors are reported on stderr.
+ */
+bool inputs_add(inputs_t *inputs, const char *spec);
+
+#endif
@@ -0,0 +1,86 @@
+#include "writer.h"
+
+#include <string.h>
+
+/* One JSON object per article and line. Strings are copied as bytes; only
+ * '"', '\\' and control characters are escaped. */
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* Nonzero for bytes that need an escape: the short form, or 'u'. */
+static char escape_of(unsigned char c) {
+    switch (c) {
+        case '"':
+            return '"';
+        case '\\':
+            return '\\';
+        case '\b':
+            return 'b';
+        case '\f':
+            return 'f';
+        case '\n':
+            return 'n';
+        case '\r':
+            return 'r';
+        case '\t':
+            return 't';
+        default:
+            return c < 0x20 ? 'u' : 0;
+    }
+}
+
+/* Escapes `text` in slices small enough that even all-escaped output fits
+ * in the reserved room. */
+static void put_string(output_t *out, arena_str_t text) {
+    size_t slice = out->cap / 6;
+    output_write(out, "\"", 1);
+    for (size_t pos = 0; pos < text.len;) {
+        size_t n = text.len - pos < slice ? text.len - pos : slice;
+        char *dst = output_reserve(out, 6 * n);
+        char *start = dst;
+        const unsigned char *src = (const unsigned char *)text.data + pos;
+        for (size_t i = 0; i < n; ++i) {
+            char escape = escape_of(src[i]);
+            if (!escape) {
+                *dst++ = (char)src[i];
+            } else if (escape != 'u') {
+                *dst++ = '\\';
+                *dst++ = escape;
+            } else {
+                memcpy(dst, "\\u00", 4);
+                dst[4] = hex_digits[src[i] >> 4];
+                dst[5] = hex_digits[src[i] & 0x0F];
+                dst += 6;
+            }
+        }
+        output_commit(out, (size_t)(dst - start));
+        pos += n;
+    }
+    output_write(out, "\"", 1);
+}
+
+static void put_literal(output_t *out, const char *text) {
+    output_write(out, text, strlen(text));
+}
+
+static void jsonl_write_batch(writer_t *writer, const article_batch_t *batch) {
+    output_t *out = &writer->out;
+    for (size_t i = 0; i < batch->len; ++i) {
+        const article_t *article = &batch->items[i];
+        put_literal(out, "{\"title\":");
+        put_string(out, article->title);
+        put_literal(out, ",\"url\":");
+        put_string(out, article->url);
+        put_literal(out, ",\"date\":");
+        put_string(out, article->date);
+        put_literal(out, ",\"author\":");
+        put_string(out, article->author);
+        put_literal(out, ",\"tags\":");
+        put_string(out, article->tags);
+        put_literal(out, "}\n");
+    }
+}
+
+const writer_ops_t writer_jsonl_ops = {
+    "jsonl", NULL, NULL, jsonl_write_batch, NULL, NULL
+};
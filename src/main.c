@@ -1,61 +1,34 @@
-#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "csv_writer.h"
 #include "extractor.h"
+#include "fetcher.h"
+#include "fixture_pool.h"
 #include "http.h"
+#include "inputs.h"
+#include "stats.h"
 #include "utils.h"
+#include "writer.h"
+
+#define MAX_INPUT_SPECS 256
 
 static void print_usage(const char *prog) {
     fprintf(stderr,
             "Usage:\n"
-            "  %s --input <file.html>\n"
-            "  %s -q <query> [--max N] [--delay-ms D] [--timeout T] [--lang en|ru]\n",
+            "  %s --input <file|dir|glob|@list> [--input ...] [--jobs N] [--order input|completion]\n"
+            "  %s -q <query> [--max N] [--delay-ms D] [--timeout T] [--lang en|ru]\n"
+            "     [--parallel N] [--burst B] [--base-url URL] [--cache-dir DIR] [--cache-ttl S]\n"
+            "     [--record FILE [--record-compress]] [--replay FILE]\n"
+            "Common options: [--format csv|jsonl|arrow] [--compress gzip|zstd[:level]] [--compress-threads N]\n"
+            "     [--output-queue N] [--selectors FILE] [--stats] [--stats-prom FILE]\n",
             prog, prog);
 }
 
-static int read_file(const char *path, char **out_data, size_t *out_size) {
-    FILE *fp = fopen(path, "rb");
-    if (!fp) {
-        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
-        return -1;
-    }
-    if (fseek(fp, 0, SEEK_END) != 0) {
-        fclose(fp);
-        return -1;
-    }
-    long length = ftell(fp);
-    if (length < 0) {
-        fclose(fp);
-        return -1;
-    }
-    if (fseek(fp, 0, SEEK_SET) != 0) {
-        fclose(fp);
-        return -1;
-    }
-    char *buffer = (char *)malloc((size_t)length + 1);
-    if (!buffer) {
-        fclose(fp);
-        return -1;
-    }
-    size_t read = fread(buffer, 1, (size_t)length, fp);
-    fclose(fp);
-    buffer[read] = '\0';
-    if (out_data) {
-        *out_data = buffer;
-    }
-    if (out_size) {
-        *out_size = read;
-    }
-    return 0;
-}
-
 static int run_fixture_mode(extractor_t *extractor, const char *path) {
     char *data = NULL;
     size_t size = 0;
-    if (read_file(path, &data, &size) != 0) {
+    if (utils_read_file(path, &data, &size) != 0) {
         return 1;
     }
     extractor_consume_html(extractor, data, size);
@@ -63,73 +36,220 @@ static int run_fixture_mode(extractor_t *extractor, const char *path) {
     return 0;
 }
 
-static int run_search_mode(extractor_t *extractor, const char *query, int max_articles, int delay_ms,
-                           long timeout_seconds, const char *lang) {
+typedef struct {
+    const char *specs[MAX_INPUT_SPECS];
+    size_t spec_count;
+    size_t jobs;
+    fixture_order_t order;
+} fixture_options_t;
+
+/* Runs every input file through the extractor, or through a pool of them
+ * with --jobs. */
+static int run_fixtures(extractor_t *extractor, const fixture_options_t *options, const char *selectors,
+                        writer_t *writer, stats_t *stats) {
+    inputs_t inputs;
+    inputs_init(&inputs);
+    for (size_t i = 0; i < options->spec_count; ++i) {
+        if (!inputs_add(&inputs, options->specs[i])) {
+            inputs_free(&inputs);
+            return 1;
+        }
+    }
+    int exit_code = 0;
+    if (options->jobs > 1) {
+        exit_code = fixture_pool_run(inputs.paths, inputs.len, options->jobs, options->order, selectors, writer, stats);
+    } else {
+        for (size_t i = 0; i < inputs.len; ++i) {
+            if (run_fixture_mode(extractor, inputs.paths[i]) != 0) {
+                exit_code = 1;
+            }
+        }
+    }
+    inputs_free(&inputs);
+    return exit_code;
+}
+
+typedef struct {
+    const char *query;
+    int max_articles;
+    int delay_ms;
+    long timeout_seconds;
+    const char *lang;
+    const char *base_url;
+    int parallel;
+    int burst;
+    const char *cache_dir;
+    long cache_ttl_seconds;
+    const char *record_path;
+    bool record_compress;
+    const char *replay_path;
+} search_options_t;
+
+typedef struct {
+    extractor_t *extractor;
+    const char *base;
+    const char *encoded_query;
+    size_t max_articles;
+    size_t page_start_count;
+} search_context_t;
+
+static bool page_url(int page, char *url, size_t cap, void *user_data) {
+    search_context_t *ctx = (search_context_t *)user_data;
+    snprintf(url, cap, "%s?q=%s&target_type=posts&order=relevance&page=%d", ctx->base, ctx->encoded_query, page);
+    return true;
+}
+
+static void page_begin(int attempt, void *user_data) {
+    search_context_t *ctx = (search_context_t *)user_data;
+    if (attempt == 0) {
+        ctx->page_start_count = extractor_get_count(ctx->extractor);
+        extractor_begin_document(ctx->extractor);
+    } else {
+        extractor_restart_document(ctx->extractor);
+    }
+}
+
+static bool page_chunk(const char *data, size_t len, void *user_data) {
+    search_context_t *ctx = (search_context_t *)user_data;
+    return extractor_feed(ctx->extractor, data, len);
+}
+
+static bool page_end(int page, void *user_data) {
+    (void)page;
+    search_context_t *ctx = (search_context_t *)user_data;
+    extractor_end_document(ctx->extractor);
+    size_t count = extractor_get_count(ctx->extractor);
+    if (count == ctx->page_start_count) {
+        return false;
+    }
+    return !extractor_is_done(ctx->extractor) && count < ctx->max_articles;
+}
+
+static int run_search_mode(extractor_t *extractor, const search_options_t *options, stats_t *stats) {
     if (http_init() != 0) {
         fprintf(stderr, "Failed to initialize HTTP layer\n");
         return 1;
     }
 
     int exit_code = 0;
-    const char *base = NULL;
-    if (strcmp(lang, "ru") == 0) {
-        base = "https://habr.com/ru/search/";
-    } else if (strcmp(lang, "en") == 0) {
-        base = "https://habr.com/en/search/";
-    } else {
-        fprintf(stderr, "Unsupported language: %s\n", lang);
+    if (strcmp(options->lang, "ru") != 0 && strcmp(options->lang, "en") != 0) {
+        fprintf(stderr, "Unsupported language: %s\n", options->lang);
         http_cleanup();
         return 1;
     }
+    char base[1024];
+    snprintf(base, sizeof(base), "%s/%s/search/", options->base_url, options->lang);
 
-    size_t query_len = strlen(query);
+    size_t query_len = strlen(options->query);
     size_t encoded_cap = query_len * 3 + 1;
     char *encoded = (char *)malloc(encoded_cap);
-    if (!encoded || !utils_urlencode(query, encoded, encoded_cap)) {
+    if (!encoded || !utils_urlencode(options->query, encoded, encoded_cap)) {
         fprintf(stderr, "Failed to encode query\n");
         free(encoded);
         http_cleanup();
         return 1;
     }
 
-    http_buffer_t buffer;
-    http_buffer_init(&buffer);
+    search_context_t ctx;
+    ctx.extractor = extractor;
+    ctx.base = base;
+    ctx.encoded_query = encoded;
+    ctx.max_articles = (size_t)options->max_articles;
+    ctx.page_start_count = 0;
 
-    for (int page = 1; !extractor_is_done(extractor) && extractor_get_count(extractor) < (size_t)max_articles;
-         ++page) {
-        char url[2048];
-        snprintf(url, sizeof(url), "%s?q=%s&target_type=posts&order=relevance&page=%d", base, encoded, page);
-        long status = 0;
-        if (http_get(url, timeout_seconds, 3, &buffer, &status) != 0) {
-            fprintf(stderr, "HTTP request failed for %s\n", url);
-            exit_code = 1;
-            break;
+    fetcher_callbacks_t callbacks;
+    callbacks.page_url = page_url;
+    callbacks.page_begin = page_begin;
+    callbacks.page_chunk = page_chunk;
+    callbacks.page_end = page_end;
+    callbacks.user_data = &ctx;
+
+    fetcher_options_t fetch_options;
+    fetch_options.parallel = options->parallel;
+    fetch_options.interval_ms = options->delay_ms;
+    fetch_options.burst = options->burst;
+    fetch_options.timeout_seconds = options->timeout_seconds;
+    fetch_options.retries = 3;
+
+    http_client_t client;
+    if (http_client_init(&client) != 0) {
+        fprintf(stderr, "Failed to initialize HTTP client\n");
+        free(encoded);
+        http_cleanup();
+        return 1;
+    }
+    http_client_set_stats(&client, stats);
+    http_cache_t cache;
+    if (options->cache_dir) {
+        if (http_cache_init(&cache, options->cache_dir, options->cache_ttl_seconds) != 0) {
+            http_client_free(&client);
+            free(encoded);
+            http_cleanup();
+            return 1;
         }
-        size_t before = extractor_get_count(extractor);
-        extractor_consume_html(extractor, buffer.data ? buffer.data : "", buffer.size);
-        size_t after = extractor_get_count(extractor);
-        if (after == before) {
-            break;
+        http_client_set_cache(&client, &cache);
+    }
+    http_archive_t record;
+    http_archive_t replay;
+    bool recording = false;
+    bool replaying = false;
+    if (options->record_path) {
+        recording = http_archive_open_record(&record, options->record_path, options->record_compress) == 0;
+        if (!recording) {
+            exit_code = 1;
         }
-        if (extractor_is_done(extractor)) {
-            break;
+        http_client_set_record(&client, &record);
+    }
+    if (exit_code == 0 && options->replay_path) {
+        replaying = http_archive_open_replay(&replay, options->replay_path) == 0;
+        if (!replaying) {
+            exit_code = 1;
         }
-        utils_sleep_ms(delay_ms);
+        http_client_set_replay(&client, &replay);
+    }
+    if (exit_code == 0 && fetcher_run(&client, &fetch_options, &callbacks) != 0) {
+        exit_code = 1;
     }
+    extractor_end_document(extractor);
 
-    http_buffer_free(&buffer);
+    if (recording) {
+        http_archive_close(&record);
+    }
+    if (replaying) {
+        http_archive_close(&replay);
+    }
+    http_client_free(&client);
     free(encoded);
     http_cleanup();
     return exit_code;
 }
 
 int main(int argc, char **argv) {
-    const char *input_path = "tests/fixtures/habr_example.html";
-    const char *query = NULL;
-    int max_articles = 100;
-    int delay_ms = 300;
-    long timeout_seconds = 15;
-    const char *lang = "en";
+    fixture_options_t fixtures;
+    fixtures.spec_count = 0;
+    fixtures.jobs = 1;
+    fixtures.order = FIXTURE_ORDER_INPUT;
+    search_options_t search;
+    search.query = NULL;
+    search.max_articles = 100;
+    search.delay_ms = 300;
+    search.timeout_seconds = 15;
+    search.lang = "en";
+    search.base_url = "https://habr.com";
+    search.parallel = 4;
+    search.burst = 1;
+    search.cache_dir = NULL;
+    search.cache_ttl_seconds = 3600;
+    search.record_path = NULL;
+    search.record_compress = false;
+    search.replay_path = NULL;
+    bool stats_enabled = false;
+    const char *stats_prom_path = NULL;
+    const char *selectors_path = NULL;
+    const writer_ops_t *format = &writer_csv_ops;
+    long output_queue = 0;
+    compress_options_t compress = {COMPRESS_NONE, 0, 0};
+    long compress_threads = 0;
 
     for (int i = 1; i < argc; ++i) {
         const char *arg = argv[i];
@@ -138,20 +258,49 @@ int main(int argc, char **argv) {
                 print_usage(argv[0]);
                 return 1;
             }
-            input_path = argv[++i];
+            if (fixtures.spec_count == MAX_INPUT_SPECS) {
+                fprintf(stderr, "Too many --input arguments; use a directory, a glob or @list\n");
+                return 1;
+            }
+            fixtures.specs[fixtures.spec_count++] = argv[++i];
+        } else if (strcmp(arg, "--jobs") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            long jobs = strtol(argv[++i], NULL, 10);
+            if (jobs <= 0) {
+                fprintf(stderr, "--jobs must be positive\n");
+                return 1;
+            }
+            fixtures.jobs = (size_t)jobs;
+        } else if (strcmp(arg, "--order") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *order = argv[++i];
+            if (strcmp(order, "input") == 0) {
+                fixtures.order = FIXTURE_ORDER_INPUT;
+            } else if (strcmp(order, "completion") == 0) {
+                fixtures.order = FIXTURE_ORDER_COMPLETION;
+            } else {
+                fprintf(stderr, "--order must be input or completion\n");
+                return 1;
+            }
         } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--query") == 0) {
             if (i + 1 >= argc) {
                 print_usage(argv[0]);
                 return 1;
             }
-            query = argv[++i];
+            search.query = argv[++i];
         } else if (strcmp(arg, "--max") == 0) {
             if (i + 1 >= argc) {
                 print_usage(argv[0]);
                 return 1;
             }
-            max_articles = (int)strtol(argv[++i], NULL, 10);
-            if (max_articles <= 0) {
+            search.max_articles = (int)strtol(argv[++i], NULL, 10);
+            if (search.max_articles <= 0) {
                 fprintf(stderr, "--max must be positive\n");
                 return 1;
             }
@@ -160,8 +309,8 @@ int main(int argc, char **argv) {
                 print_usage(argv[0]);
                 return 1;
             }
-            delay_ms = (int)strtol(argv[++i], NULL, 10);
-            if (delay_ms < 0) {
+            search.delay_ms = (int)strtol(argv[++i], NULL, 10);
+            if (search.delay_ms < 0) {
                 fprintf(stderr, "--delay-ms must be non-negative\n");
                 return 1;
             }
@@ -170,8 +319,8 @@ int main(int argc, char **argv) {
                 print_usage(argv[0]);
                 return 1;
             }
-            timeout_seconds = strtol(argv[++i], NULL, 10);
-            if (timeout_seconds <= 0) {
+            search.timeout_seconds = strtol(argv[++i], NULL, 10);
+            if (search.timeout_seconds <= 0) {
                 fprintf(stderr, "--timeout must be positive\n");
                 return 1;
             }
@@ -180,7 +329,117 @@ int main(int argc, char **argv) {
                 print_usage(argv[0]);
                 return 1;
             }
-            lang = argv[++i];
+            search.lang = argv[++i];
+        } else if (strcmp(arg, "--base-url") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.base_url = argv[++i];
+        } else if (strcmp(arg, "--cache-dir") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.cache_dir = argv[++i];
+        } else if (strcmp(arg, "--cache-ttl") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.cache_ttl_seconds = strtol(argv[++i], NULL, 10);
+            if (search.cache_ttl_seconds < 0) {
+                fprintf(stderr, "--cache-ttl must be non-negative\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--record") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.record_path = argv[++i];
+        } else if (strcmp(arg, "--record-compress") == 0) {
+            search.record_compress = true;
+        } else if (strcmp(arg, "--replay") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.replay_path = argv[++i];
+        } else if (strcmp(arg, "--parallel") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.parallel = (int)strtol(argv[++i], NULL, 10);
+            if (search.parallel <= 0) {
+                fprintf(stderr, "--parallel must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--burst") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            search.burst = (int)strtol(argv[++i], NULL, 10);
+            if (search.burst <= 0) {
+                fprintf(stderr, "--burst must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--selectors") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            selectors_path = argv[++i];
+        } else if (strcmp(arg, "--format") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            format = writer_find(argv[++i]);
+            if (!format) {
+                fprintf(stderr, "Unknown output format: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--compress") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (!compress_parse(argv[++i], &compress)) {
+                fprintf(stderr, "Invalid --compress value: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--compress-threads") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            compress_threads = strtol(argv[++i], NULL, 10);
+            if (compress_threads < 0) {
+                fprintf(stderr, "--compress-threads must be non-negative\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--output-queue") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            output_queue = strtol(argv[++i], NULL, 10);
+            if (output_queue <= 0) {
+                fprintf(stderr, "--output-queue must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--stats") == 0) {
+            stats_enabled = true;
+        } else if (strcmp(arg, "--stats-prom") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            stats_prom_path = argv[++i];
+            stats_enabled = true;
         } else {
             fprintf(stderr, "Unknown argument: %s\n", arg);
             print_usage(argv[0]);
@@ -188,16 +447,88 @@ int main(int argc, char **argv) {
         }
     }
 
-    csv_writer_t writer;
-    csv_writer_init(&writer, stdout);
-    csv_writer_write_header(&writer);
+    if (compress_threads > 0 && compress.kind != COMPRESS_ZSTD) {
+        fprintf(stderr, "--compress-threads needs --compress zstd\n");
+        return 1;
+    }
+    compress.threads = (int)compress_threads;
+    if (fixtures.spec_count == 0) {
+        fixtures.specs[fixtures.spec_count++] = "tests/fixtures/habr_example.html";
+    }
+
+    long long started_us = utils_now_us();
+    writer_t writer;
+    if (!writer_init(&writer, format, stdout)) {
+        fprintf(stderr, "Failed to initialize the %s writer\n", format->name);
+        return 1;
+    }
+    if (compress.kind != COMPRESS_NONE && !output_set_compression(&writer.out, &compress)) {
+        writer_free(&writer);
+        return 1;
+    }
 
     extractor_t extractor;
-    extractor_init(&extractor, &writer, query ? (size_t)max_articles : 0);
+    if (!extractor_init(&extractor, &writer, search.query ? (size_t)search.max_articles : 0)) {
+        fprintf(stderr, "Failed to initialize the extractor\n");
+        writer_free(&writer);
+        return 1;
+    }
+    char *selectors = NULL;
+    if (selectors_path) {
+        if (utils_read_file(selectors_path, &selectors, NULL) != 0) {
+            extractor_free(&extractor);
+            writer_free(&writer);
+            return 1;
+        }
+        if (!extractor_set_selectors(&extractor, selectors)) {
+            fprintf(stderr, "Invalid selectors in %s\n", selectors_path);
+            free(selectors);
+            extractor_free(&extractor);
+            writer_free(&writer);
+            return 1;
+        }
+    }
+    writer_begin(&writer);
+    if (output_queue > 0 && !writer_start_thread(&writer, (size_t)output_queue)) {
+        fprintf(stderr, "Failed to start the output thread\n");
+        free(selectors);
+        extractor_free(&extractor);
+        writer_free(&writer);
+        return 1;
+    }
 
-    if (query) {
-        return run_search_mode(&extractor, query, max_articles, delay_ms, timeout_seconds, lang);
+    stats_t stats;
+    stats_init(&stats);
+    if (stats_enabled) {
+        extractor_set_stats(&extractor, &stats);
     }
-    return run_fixture_mode(&extractor, input_path);
+
+    int exit_code;
+    if (search.query) {
+        exit_code = run_search_mode(&extractor, &search, stats_enabled ? &stats : NULL);
+    } else {
+        exit_code = run_fixtures(&extractor, &fixtures, selectors, &writer, stats_enabled ? &stats : NULL);
+    }
+
+    if (writer_end(&writer) != 0) {
+        fprintf(stderr, "Failed to write output\n");
+        exit_code = 1;
+    }
+    if (stats_enabled) {
+        stats.wall_us = utils_now_us() - started_us;
+        stats.bytes_written = writer.out.bytes_written;
+        if (stats_prom_path) {
+            if (stats_write_prometheus(&stats, stats_prom_path) != 0) {
+                exit_code = 1;
+            }
+        } else {
+            stats_print_json(&stats, stderr);
+        }
+    }
+    free(selectors);
+    extractor_free(&extractor);
+    writer_free(&writer);
+    stats_free(&stats);
+    return exit_code;
 }
 
@@ -0,0 +1,164 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "output.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/* Writes `first` followed by `second` to the file. Streams without a file
+ * descriptor, e.g. memory streams, go through stdio instead. */
+static void write_parts(output_t *out, const char *first, size_t first_len, const char *second, size_t second_len) {
+    const char *parts[2] = {first, second};
+    size_t lens[2] = {first_len, second_len};
+    if (out->failed) {
+        return;
+    }
+#ifndef _WIN32
+    int fd = fileno(out->file);
+    if (fd >= 0) {
+        if (fflush(out->file) != 0) {
+            out->failed = true;
+            return;
+        }
+        struct iovec iov[2];
+        int count = 0;
+        for (int i = 0; i < 2; ++i) {
+            if (lens[i] > 0) {
+                iov[count].iov_base = (void *)parts[i];
+                iov[count].iov_len = lens[i];
+                count++;
+            }
+        }
+        struct iovec *next = iov;
+        while (count > 0) {
+            ssize_t written = writev(fd, next, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                out->failed = true;
+                return;
+            }
+            size_t done = (size_t)written;
+            while (count > 0 && done >= next->iov_len) {
+                done -= next->iov_len;
+                ++next;
+                --count;
+            }
+            if (count > 0) {
+                next->iov_base = (char *)next->iov_base + done;
+                next->iov_len -= done;
+            }
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < 2; ++i) {
+        if (lens[i] > 0 && fwrite(parts[i], 1, lens[i], out->file) != lens[i]) {
+            out->failed = true;
+            return;
+        }
+    }
+}
+
+static bool write_compressed(const void *data, size_t len, void *user_data) {
+    output_t *out = (output_t *)user_data;
+    write_parts(out, (const char *)data, len, NULL, 0);
+    return !out->failed;
+}
+
+/* Writes the buffered bytes followed by `extra`, through the compressor if
+ * there is one; `finish` ends the compressed stream. */
+static void flush_with(output_t *out, const char *extra, size_t extra_len, bool finish) {
+    size_t len = out->len;
+    out->len = 0;
+    if (out->failed) {
+        return;
+    }
+    if (!out->compress) {
+        write_parts(out, out->buf, len, extra, extra_len);
+        return;
+    }
+    if (!compress_write(out->compress, out->buf, len, finish && extra_len == 0, write_compressed, out) ||
+        (extra_len > 0 && !compress_write(out->compress, extra, extra_len, finish, write_compressed, out))) {
+        out->failed = true;
+    }
+}
+
+void output_write(output_t *out, const void *data, size_t len) {
+    out->bytes_written += len;
+    if (len <= out->cap - out->len) {
+        memcpy(out->buf + out->len, data, len);
+        out->len += len;
+        return;
+    }
+    if (len >= out->cap / 2) {
+        flush_with(out, data, len, false);
+        return;
+    }
+    flush_with(out, NULL, 0, false);
+    memcpy(out->buf, data, len);
+    out->len = len;
+}
+
+char *output_reserve(output_t *out, size_t len) {
+    if (len > out->cap) {
+        return NULL;
+    }
+    if (len > out->cap - out->len) {
+        flush_with(out, NULL, 0, false);
+    }
+    return out->buf + out->len;
+}
+
+void output_commit(output_t *out, size_t len) {
+    out->len += len;
+    out->bytes_written += len;
+}
+
+bool output_init(output_t *out, FILE *file) {
+    out->file = file;
+    out->bytes_written = 0;
+    out->len = 0;
+    out->cap = OUTPUT_BUFFER_SIZE;
+    out->failed = false;
+    out->compress = NULL;
+    out->buf = (char *)malloc(out->cap);
+    return out->buf != NULL;
+}
+
+void output_free(output_t *out) {
+    compress_free(out->compress);
+    out->compress = NULL;
+    free(out->buf);
+    out->buf = NULL;
+    out->len = 0;
+}
+
+bool output_set_compression(output_t *out, const compress_options_t *options) {
+    compress_t *compress = compress_new(options);
+    if (!compress) {
+        return false;
+    }
+    flush_with(out, NULL, 0, false);
+    compress_free(out->compress);
+    out->compress = compress;
+    return true;
+}
+
+int output_flush(output_t *out) {
+    flush_with(out, NULL, 0, true);
+    if (!out->failed && fflush(out->file) != 0) {
+        out->failed = true;
+    }
+    return out->failed ? -1 : 0;
+}
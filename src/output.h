@@ -0,0 +1,44 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "compress.h"
+
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+
+/*
+ * Buffered byte sink shared by the output formats. Bytes collect in `buf`
+ * and reach `file` in large writes, so output is complete only after
+ * output_flush(). Writes larger than half the buffer go out together with
+ * it, without being copied.
+ */
+typedef struct {
+    FILE *file;
+    size_t bytes_written;
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool failed;
+    compress_t *compress;
+} output_t;
+
+/* Returns false when out of memory. */
+bool output_init(output_t *out, FILE *file);
+/* Frees the buffer without flushing it. */
+void output_free(output_t *out);
+void output_write(output_t *out, const void *data, size_t len);
+/* Room for `len` bytes at the end of the buffer, flushing first if needed;
+ * NULL when `len` exceeds the buffer. Follow with output_commit(). */
+char *output_reserve(output_t *out, size_t len);
+void output_commit(output_t *out, size_t len);
+/* Compresses everything written from now on; `bytes_written` keeps counting
+ * uncompressed bytes. Returns false if the codec is unavailable. */
+bool output_set_compression(output_t *out, const compress_options_t *options);
+/* Also ends the compressed stream, if any. Returns -1 if this or any earlier
+ * write to `file` failed. */
+int output_flush(output_t *out);
+
+#endif
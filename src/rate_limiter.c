@@ -0,0 +1,42 @@
+#include "rate_limiter.h"
+
+static void refill(rate_limiter_t *limiter, long long now_ms) {
+    if (limiter->interval_ms <= 0) {
+        limiter->tokens = limiter->capacity;
+        limiter->last_ms = now_ms;
+        return;
+    }
+    if (now_ms > limiter->last_ms) {
+        limiter->tokens += (double)(now_ms - limiter->last_ms) / (double)limiter->interval_ms;
+        if (limiter->tokens > limiter->capacity) {
+            limiter->tokens = limiter->capacity;
+        }
+    }
+    limiter->last_ms = now_ms;
+}
+
+void rate_limiter_init(rate_limiter_t *limiter, long interval_ms, int burst, long long now_ms) {
+    limiter->capacity = burst > 0 ? (double)burst : 1.0;
+    limiter->tokens = limiter->capacity;
+    limiter->interval_ms = interval_ms;
+    limiter->last_ms = now_ms;
+}
+
+bool rate_limiter_try_acquire(rate_limiter_t *limiter, long long now_ms) {
+    refill(limiter, now_ms);
+    if (limiter->tokens < 1.0) {
+        return false;
+    }
+    limiter->tokens -= 1.0;
+    return true;
+}
+
+long rate_limiter_wait_ms(rate_limiter_t *limiter, long long now_ms) {
+    refill(limiter, now_ms);
+    if (limiter->tokens >= 1.0) {
+        return 0;
+    }
+    double missing = 1.0 - limiter->tokens;
+    long wait = (long)(missing * (double)limiter->interval_ms);
+    return wait > 0 ? wait : 1;
+}
@@ -0,0 +1,18 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <stdbool.h>
+
+/* Token bucket: one token every interval_ms, at most `burst` saved up. */
+typedef struct {
+    double tokens;
+    double capacity;
+    long interval_ms;
+    long long last_ms;
+} rate_limiter_t;
+
+void rate_limiter_init(rate_limiter_t *limiter, long interval_ms, int burst, long long now_ms);
+bool rate_limiter_try_acquire(rate_limiter_t *limiter, long long now_ms);
+long rate_limiter_wait_ms(rate_limiter_t *limiter, long long now_ms);
+
+#endif
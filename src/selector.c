@@ -0,0 +1,461 @@
+#include "selector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    html_tag_t tag;
+    size_t class_count;
+    const char *classes[SELECTOR_STEP_CLASSES];
+} step_t;
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static char *trim(char *s) {
+    while (is_space(*s)) {
+        ++s;
+    }
+    size_t len = strlen(s);
+    while (len > 0 && is_space(s[len - 1])) {
+        s[--len] = '\0';
+    }
+    return s;
+}
+
+static void lowercase(char *s) {
+    for (; *s; ++s) {
+        if (*s >= 'A' && *s <= 'Z') {
+            *s = (char)(*s | 0x20);
+        }
+    }
+}
+
+static unsigned lowest_bit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(mask);
+#else
+    unsigned bit = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+static bool parse_step(char *text, step_t *step, size_t line) {
+    memset(step, 0, sizeof(*step));
+    char *dot = strchr(text, '.');
+    if (dot) {
+        *dot = '\0';
+    }
+    if (text[0] != '\0' && strcmp(text, "*") != 0) {
+        lowercase(text);
+        step->tag = html_tag_lookup(text, strlen(text));
+        if (step->tag == HTML_TAG_UNKNOWN) {
+            fprintf(stderr, "selector line %zu: unknown element '%s'\n", line, text);
+            return false;
+        }
+    }
+    while (dot) {
+        char *name = dot + 1;
+        dot = strchr(name, '.');
+        if (dot) {
+            *dot = '\0';
+        }
+        if (name[0] == '\0') {
+            fprintf(stderr, "selector line %zu: empty class name\n", line);
+            return false;
+        }
+        if (step->class_count == SELECTOR_STEP_CLASSES) {
+            fprintf(stderr, "selector line %zu: more than %d classes in one step\n", line, SELECTOR_STEP_CLASSES);
+            return false;
+        }
+        step->classes[step->class_count++] = name;
+    }
+    if (step->tag == HTML_TAG_UNKNOWN && step->class_count == 0) {
+        fprintf(stderr, "selector line %zu: a step needs an element or a class\n", line);
+        return false;
+    }
+    return true;
+}
+
+static bool same_step(const selector_node_t *node, const step_t *step) {
+    if (node->tag != step->tag || node->class_count != step->class_count) {
+        return false;
+    }
+    for (size_t i = 0; i < step->class_count; ++i) {
+        if (strcmp(node->classes[i].name, step->classes[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Index of the child of `parent` for `step`, added if needed; -1 when full. */
+static int child_node(selector_t *selector, int parent, const step_t *step, size_t line) {
+    uint64_t children = selector->nodes[parent].children;
+    while (children) {
+        unsigned n = lowest_bit(children);
+        children &= children - 1;
+        if (same_step(&selector->nodes[n], step)) {
+            return (int)n;
+        }
+    }
+    if (selector->node_count == SELECTOR_MAX_NODES) {
+        fprintf(stderr, "selector line %zu: more than %d distinct steps\n", line, SELECTOR_MAX_NODES - 1);
+        return -1;
+    }
+    int index = (int)selector->node_count++;
+    selector_node_t *node = &selector->nodes[index];
+    node->tag = step->tag;
+    node->class_count = step->class_count;
+    for (size_t i = 0; i < step->class_count; ++i) {
+        html_class_key_init(&node->classes[i], step->classes[i]);
+    }
+    selector->nodes[parent].children |= 1ULL << index;
+    return index;
+}
+
+static int find_field(const char *name, const char *const *fields, size_t field_count) {
+    for (size_t i = 0; i < field_count; ++i) {
+        if (strcmp(name, fields[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool parse_action(selector_node_t *node, char *action, const char *const *fields, size_t field_count,
+                         size_t line) {
+    if (strcmp(action, "record") == 0) {
+        node->record = true;
+        return true;
+    }
+    const char *attr = NULL;
+    const char *field_name = action;
+    if (action[0] == '@') {
+        char *colon = strchr(action, ':');
+        if (!colon) {
+            fprintf(stderr, "selector line %zu: expected @attr:field in '%s'\n", line, action);
+            return false;
+        }
+        *colon = '\0';
+        lowercase(action + 1);
+        attr = trim(action + 1);
+        field_name = trim(colon + 1);
+    }
+    int field = find_field(field_name, fields, field_count);
+    if (field < 0) {
+        fprintf(stderr, "selector line %zu: unknown field '%s'\n", line, field_name);
+        return false;
+    }
+    if (!attr) {
+        node->text_fields |= 1u << field;
+        return true;
+    }
+    if (node->attr_count == SELECTOR_NODE_ATTRS) {
+        fprintf(stderr, "selector line %zu: more than %d attribute actions\n", line, SELECTOR_NODE_ATTRS);
+        return false;
+    }
+    node->attr_names[node->attr_count] = attr;
+    node->attr_fields[node->attr_count] = field;
+    node->attr_count++;
+    return true;
+}
+
+static bool parse_rule(selector_t *selector, char *text, const char *const *fields, size_t field_count,
+                       size_t line) {
+    char *arrow = strstr(text, "->");
+    if (!arrow) {
+        fprintf(stderr, "selector line %zu: expected 'selector -> actions'\n", line);
+        return false;
+    }
+    *arrow = '\0';
+    char *actions = arrow + 2;
+
+    int node = 0;
+    char *p = text;
+    while (*p) {
+        while (is_space(*p)) {
+            ++p;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        char *start = p;
+        while (*p && !is_space(*p)) {
+            ++p;
+        }
+        if (*p) {
+            *p++ = '\0';
+        }
+        step_t step;
+        if (!parse_step(start, &step, line)) {
+            return false;
+        }
+        node = child_node(selector, node, &step, line);
+        if (node < 0) {
+            return false;
+        }
+    }
+    if (node == 0) {
+        fprintf(stderr, "selector line %zu: empty selector\n", line);
+        return false;
+    }
+
+    while (actions) {
+        char *comma = strchr(actions, ',');
+        if (comma) {
+            *comma = '\0';
+        }
+        char *action = trim(actions);
+        if (action[0] == '\0') {
+            fprintf(stderr, "selector line %zu: empty action\n", line);
+            return false;
+        }
+        if (!parse_action(&selector->nodes[node], action, fields, field_count, line)) {
+            return false;
+        }
+        actions = comma ? comma + 1 : NULL;
+    }
+    return true;
+}
+
+static void build_tables(selector_t *selector) {
+    for (size_t n = 1; n < selector->node_count; ++n) {
+        const selector_node_t *node = &selector->nodes[n];
+        if (node->tag == HTML_TAG_UNKNOWN) {
+            selector->any_edges |= 1ULL << n;
+        } else {
+            selector->tag_edges[node->tag] |= 1ULL << n;
+        }
+    }
+    uint64_t top = selector->nodes[0].children;
+    if (top != 0 && (top & (top - 1)) == 0) {
+        const selector_node_t *node = &selector->nodes[lowest_bit(top)];
+        if (node->record && node->tag != HTML_TAG_UNKNOWN) {
+            snprintf(selector->seek, sizeof(selector->seek), "<%s", html_tag_name(node->tag));
+        }
+    }
+}
+
+bool selector_compile(selector_t *selector, const char *spec, const char *const *fields, size_t field_count) {
+    memset(selector, 0, sizeof(*selector));
+    selector->node_count = 1;
+    if (field_count > SELECTOR_MAX_FIELDS) {
+        fprintf(stderr, "selector: more than %d fields\n", SELECTOR_MAX_FIELDS);
+        return false;
+    }
+    size_t spec_len = strlen(spec);
+    selector->strings = (char *)malloc(spec_len + 1);
+    if (!selector->strings) {
+        return false;
+    }
+    memcpy(selector->strings, spec, spec_len + 1);
+    size_t line = 0;
+    char *p = selector->strings;
+    while (p) {
+        ++line;
+        char *newline = strchr(p, '\n');
+        if (newline) {
+            *newline = '\0';
+        }
+        char *comment = strchr(p, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char *text = trim(p);
+        if (text[0] != '\0' && !parse_rule(selector, text, fields, field_count, line)) {
+            return false;
+        }
+        p = newline ? newline + 1 : NULL;
+    }
+    build_tables(selector);
+    return true;
+}
+
+void selector_free(selector_t *selector) {
+    free(selector->strings);
+    selector->strings = NULL;
+}
+
+static bool is_void(html_tag_t tag) {
+    switch (tag) {
+        case HTML_TAG_AREA:
+        case HTML_TAG_BASE:
+        case HTML_TAG_BR:
+        case HTML_TAG_COL:
+        case HTML_TAG_EMBED:
+        case HTML_TAG_HR:
+        case HTML_TAG_IMG:
+        case HTML_TAG_INPUT:
+        case HTML_TAG_LINK:
+        case HTML_TAG_META:
+        case HTML_TAG_PARAM:
+        case HTML_TAG_SOURCE:
+        case HTML_TAG_TRACK:
+        case HTML_TAG_WBR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Tells unknown elements apart on the stack; known ones go by tag id. */
+static uint32_t unknown_name_hash(const token_t *token) {
+    if (token->tag_id != HTML_TAG_UNKNOWN) {
+        return 0;
+    }
+    uint32_t hash = HTML_TAG_HASH_INIT;
+    for (size_t i = 0; i < token->tag_len; ++i) {
+        hash = HTML_TAG_HASH_STEP(hash, (unsigned char)token->tag[i]);
+    }
+    return hash;
+}
+
+static bool step_matches(const selector_node_t *node, const token_t *token) {
+    for (size_t i = 0; i < node->class_count; ++i) {
+        if (!html_token_has_class(token, &node->classes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void selector_matcher_init(selector_matcher_t *matcher, const selector_t *selector,
+                           const selector_sink_t *sink, void *user_data) {
+    matcher->selector = selector;
+    matcher->sink = sink;
+    matcher->user_data = user_data;
+    selector_matcher_reset(matcher);
+}
+
+void selector_matcher_reset(selector_matcher_t *matcher) {
+    selector_entry_t *root = &matcher->stack[0];
+    memset(root, 0, sizeof(*root));
+    root->active = 1;
+    root->frontier = matcher->selector->nodes[0].children;
+    matcher->depth = 1;
+    matcher->overflow = 0;
+    matcher->in_record = false;
+}
+
+static void apply_matches(selector_matcher_t *matcher, selector_entry_t *entry, const token_t *token,
+                          uint64_t matched) {
+    const selector_t *selector = matcher->selector;
+    const selector_sink_t *sink = matcher->sink;
+    uint32_t fields = 0;
+    for (uint64_t m = matched; m; m &= m - 1) {
+        const selector_node_t *node = &selector->nodes[lowest_bit(m)];
+        entry->frontier |= node->children;
+        fields |= node->text_fields;
+        if (node->record && !matcher->in_record) {
+            matcher->in_record = true;
+            entry->record = true;
+            sink->record_begin(matcher->user_data);
+        }
+    }
+    entry->active |= matched;
+    entry->opened_fields = fields & ~entry->text_fields;
+    entry->text_fields |= fields;
+    for (uint32_t f = entry->opened_fields; f; f &= f - 1) {
+        sink->field_begin(matcher->user_data, (int)lowest_bit(f));
+    }
+    for (uint64_t m = matched; m; m &= m - 1) {
+        const selector_node_t *node = &selector->nodes[lowest_bit(m)];
+        for (size_t i = 0; i < node->attr_count; ++i) {
+            const char *value = NULL;
+            size_t value_len = 0;
+            if (html_token_attr(token, node->attr_names[i], &value, &value_len)) {
+                sink->field_value(matcher->user_data, node->attr_fields[i], value, value_len);
+            }
+        }
+    }
+}
+
+static void pop_element(selector_matcher_t *matcher) {
+    const selector_entry_t *entry = &matcher->stack[--matcher->depth];
+    for (uint32_t f = entry->opened_fields; f; f &= f - 1) {
+        matcher->sink->field_end(matcher->user_data, (int)lowest_bit(f));
+    }
+    if (entry->record) {
+        matcher->in_record = false;
+        matcher->sink->record_end(matcher->user_data);
+    }
+}
+
+static void start_element(selector_matcher_t *matcher, const token_t *token) {
+    const selector_t *selector = matcher->selector;
+    const selector_entry_t *parent = &matcher->stack[matcher->depth - 1];
+    uint64_t candidates = parent->frontier & (selector->tag_edges[token->tag_id] | selector->any_edges);
+    bool void_element = is_void(token->tag_id);
+    if (candidates == 0 && void_element) {
+        return;
+    }
+    if (matcher->depth == SELECTOR_STACK_CAP) {
+        matcher->overflow++;
+        return;
+    }
+    selector_entry_t *entry = &matcher->stack[matcher->depth++];
+    *entry = *parent;
+    entry->tag = token->tag_id;
+    entry->name_hash = unknown_name_hash(token);
+    entry->opened_fields = 0;
+    entry->record = false;
+    uint64_t matched = 0;
+    for (uint64_t c = candidates; c; c &= c - 1) {
+        unsigned n = lowest_bit(c);
+        if (step_matches(&selector->nodes[n], token)) {
+            matched |= 1ULL << n;
+        }
+    }
+    if (matched) {
+        apply_matches(matcher, entry, token, matched);
+    }
+    if (void_element) {
+        pop_element(matcher);
+    }
+}
+
+static void end_element(selector_matcher_t *matcher, const token_t *token) {
+    if (is_void(token->tag_id)) {
+        return;
+    }
+    if (matcher->overflow > 0) {
+        matcher->overflow--;
+        return;
+    }
+    uint32_t name_hash = unknown_name_hash(token);
+    size_t i = matcher->depth;
+    while (i > 1 && (matcher->stack[i - 1].tag != token->tag_id || matcher->stack[i - 1].name_hash != name_hash)) {
+        --i;
+    }
+    if (i <= 1) {
+        return;
+    }
+    while (matcher->depth >= i) {
+        pop_element(matcher);
+    }
+}
+
+void selector_matcher_token(selector_matcher_t *matcher, const token_t *token) {
+    switch (token->type) {
+        case TOKEN_START_TAG:
+            start_element(matcher, token);
+            break;
+        case TOKEN_END_TAG:
+            end_element(matcher, token);
+            break;
+        case TOKEN_TEXT: {
+            uint32_t fields = matcher->stack[matcher->depth - 1].text_fields;
+            for (; fields; fields &= fields - 1) {
+                matcher->sink->field_text(matcher->user_data, (int)lowest_bit(fields), token->text, token->text_len);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef SELECTOR_H
+#define SELECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "html_scan.h"
+
+#define SELECTOR_MAX_NODES 64
+#define SELECTOR_MAX_FIELDS 32
+#define SELECTOR_STEP_CLASSES 4
+#define SELECTOR_NODE_ATTRS 4
+#define SELECTOR_STACK_CAP 256
+
+/*
+ * Extraction rules, one per line:
+ *
+ *     article.tm-articles-list__item -> record
+ *     article.tm-articles-list__item a.tm-title__link -> title, @href:url
+ *
+ * The left side is a descendant selector: steps of `tag.class.class`, where
+ * the tag may be omitted or `*` to match any element. The right side lists
+ * actions for matching elements: `record` delimits one output record,
+ * `field` collects the element's text into a field, `@attr:field` sets a
+ * field from an attribute. `#` starts a comment.
+ *
+ * Rules compile into a trie of steps. Every node is a bit; `tag_edges`
+ * holds, per tag id, the nodes whose step names that tag, so a start tag
+ * costs one lookup ANDed with the nodes reachable from its parent.
+ */
+typedef struct {
+    html_tag_t tag;
+    size_t class_count;
+    html_class_key_t classes[SELECTOR_STEP_CLASSES];
+    uint64_t children;
+    bool record;
+    uint32_t text_fields;
+    size_t attr_count;
+    const char *attr_names[SELECTOR_NODE_ATTRS];
+    int attr_fields[SELECTOR_NODE_ATTRS];
+} selector_node_t;
+
+typedef struct {
+    char *strings;
+    size_t node_count;
+    selector_node_t nodes[SELECTOR_MAX_NODES];
+    uint64_t tag_edges[HTML_TAG_COUNT];
+    uint64_t any_edges;
+    /* "<tag" when every rule starts at a single-step record, so that text
+     * between records can be skipped with html_scanner_skip_to(); else "". */
+    char seek[32];
+} selector_t;
+
+/* `fields` names the fields rules may write to; actions refer to them by
+ * index. Errors are reported on stderr with their line number. */
+bool selector_compile(selector_t *selector, const char *spec, const char *const *fields, size_t field_count);
+void selector_free(selector_t *selector);
+
+/* Events from the matcher. A field is begun and ended once per outermost
+ * element that collects it; text arrives in between. */
+typedef struct {
+    void (*record_begin)(void *user_data);
+    void (*record_end)(void *user_data);
+    void (*field_begin)(void *user_data, int field);
+    void (*field_text)(void *user_data, int field, const char *text, size_t len);
+    void (*field_end)(void *user_data, int field);
+    void (*field_value)(void *user_data, int field, const char *value, size_t len);
+} selector_sink_t;
+
+typedef struct {
+    html_tag_t tag;
+    uint32_t name_hash;
+    uint64_t active;
+    uint64_t frontier;
+    uint32_t text_fields;
+    uint32_t opened_fields;
+    bool record;
+} selector_entry_t;
+
+/* Open-element stack for one document. End tags close the nearest open
+ * element with the same name and everything above it; void elements close
+ * immediately. */
+typedef struct {
+    const selector_t *selector;
+    const selector_sink_t *sink;
+    void *user_data;
+    bool in_record;
+    size_t depth;
+    size_t overflow;
+    selector_entry_t stack[SELECTOR_STACK_CAP];
+} selector_matcher_t;
+
+void selector_matcher_init(selector_matcher_t *matcher, const selector_t *selector,
+                           const selector_sink_t *sink, void *user_data);
+/* Forgets all open elements without reporting them, e.g. before the scanner
+ * skips ahead. */
+void selector_matcher_reset(selector_matcher_t *matcher);
+void selector_matcher_token(selector_matcher_t *matcher, const token_t *token);
+
+#endif
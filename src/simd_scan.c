@@ -0,0 +1,363 @@
+#include "simd_scan.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_SCAN_X86 1
+#define SIMD_SCAN_DISPATCH 1
+#include <immintrin.h>
+#define SIMD_TARGET(t) __attribute__((target(t)))
+#define SIMD_CTZ32(m) ((unsigned)__builtin_ctz(m))
+#define SIMD_CTZ64(m) ((unsigned)__builtin_ctzll(m))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+#define SIMD_SCAN_X86 1
+#include <intrin.h>
+#include <immintrin.h>
+#define SIMD_TARGET(t)
+static unsigned simd_ctz32(unsigned m) {
+    unsigned long index;
+    _BitScanForward(&index, m);
+    return (unsigned)index;
+}
+#define SIMD_CTZ32(m) simd_ctz32((unsigned)(m))
+#endif
+
+static const char *find1_scalar(const char *p, const char *end, char a) {
+    const char *hit = (const char *)memchr(p, a, (size_t)(end - p));
+    return hit ? hit : end;
+}
+
+static const char *find2_scalar(const char *p, const char *end, char a, char b) {
+    while (p < end && *p != a && *p != b) {
+        ++p;
+    }
+    return p;
+}
+
+static const char *find3_scalar(const char *p, const char *end, char a, char b, char c) {
+    while (p < end && *p != a && *p != b && *p != c) {
+        ++p;
+    }
+    return p;
+}
+
+/* \t \n \v \f \r are 0x09..0x0D. */
+static bool is_control_space(char c) {
+    return (unsigned char)(c - 0x09) <= 0x04;
+}
+
+static const char *find_text_special_scalar(const char *p, const char *end) {
+    for (; p < end; ++p) {
+        if (*p == '&' || is_control_space(*p)) {
+            return p;
+        }
+        if (*p == ' ' && (p + 1 == end || p[1] == ' ' || is_control_space(p[1]))) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static const simd_kernels_t kernels_scalar = {
+    SIMD_LEVEL_SCALAR, "scalar", find1_scalar, find2_scalar, find3_scalar, find_text_special_scalar
+};
+
+#ifdef SIMD_SCAN_X86
+
+static const char *find1_sse2(const char *p, const char *end, char a) {
+    const __m128i va = _mm_set1_epi8(a);
+    while (end - p >= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, va));
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 16;
+    }
+    return find1_scalar(p, end, a);
+}
+
+static const char *find2_sse2(const char *p, const char *end, char a, char b) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb));
+        unsigned m = (unsigned)_mm_movemask_epi8(eq);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 16;
+    }
+    return find2_scalar(p, end, a, b);
+}
+
+static const char *find3_sse2(const char *p, const char *end, char a, char b, char c) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                  _mm_cmpeq_epi8(x, vc));
+        unsigned m = (unsigned)_mm_movemask_epi8(eq);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 16;
+    }
+    return find3_scalar(p, end, a, b, c);
+}
+
+static __m128i control_space_sse2(__m128i x) {
+    __m128i off = _mm_sub_epi8(x, _mm_set1_epi8(0x09));
+    return _mm_cmpeq_epi8(_mm_min_epu8(off, _mm_set1_epi8(0x04)), off);
+}
+
+/* Each block also loads the bytes one further on, to see what follows a space. */
+static const char *find_text_special_sse2(const char *p, const char *end) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i space = _mm_set1_epi8(' ');
+    while (end - p > 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i next = _mm_loadu_si128((const __m128i *)(p + 1));
+        __m128i next_space = _mm_or_si128(_mm_cmpeq_epi8(next, space), control_space_sse2(next));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, amp), control_space_sse2(x)),
+                                   _mm_and_si128(_mm_cmpeq_epi8(x, space), next_space));
+        unsigned m = (unsigned)_mm_movemask_epi8(hit);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 16;
+    }
+    return find_text_special_scalar(p, end);
+}
+
+static const simd_kernels_t kernels_sse2 = {
+    SIMD_LEVEL_SSE2, "sse2", find1_sse2, find2_sse2, find3_sse2, find_text_special_sse2
+};
+
+#endif
+
+#ifdef SIMD_SCAN_DISPATCH
+
+SIMD_TARGET("avx2")
+static const char *find1_avx2(const char *p, const char *end, char a) {
+    const __m256i va = _mm256_set1_epi8(a);
+    while (end - p >= 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, va));
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 32;
+    }
+    return find1_sse2(p, end, a);
+}
+
+SIMD_TARGET("avx2")
+static const char *find2_avx2(const char *p, const char *end, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    while (end - p >= 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb));
+        unsigned m = (unsigned)_mm256_movemask_epi8(eq);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 32;
+    }
+    return find2_sse2(p, end, a, b);
+}
+
+SIMD_TARGET("avx2")
+static const char *find3_avx2(const char *p, const char *end, char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb)),
+                                     _mm256_cmpeq_epi8(x, vc));
+        unsigned m = (unsigned)_mm256_movemask_epi8(eq);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 32;
+    }
+    return find3_sse2(p, end, a, b, c);
+}
+
+SIMD_TARGET("avx2")
+static __m256i control_space_avx2(__m256i x) {
+    __m256i off = _mm256_sub_epi8(x, _mm256_set1_epi8(0x09));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(off, _mm256_set1_epi8(0x04)), off);
+}
+
+SIMD_TARGET("avx2")
+static const char *find_text_special_avx2(const char *p, const char *end) {
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i space = _mm256_set1_epi8(' ');
+    while (end - p > 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        __m256i next = _mm256_loadu_si256((const __m256i *)(p + 1));
+        __m256i next_space = _mm256_or_si256(_mm256_cmpeq_epi8(next, space), control_space_avx2(next));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, amp), control_space_avx2(x)),
+                                      _mm256_and_si256(_mm256_cmpeq_epi8(x, space), next_space));
+        unsigned m = (unsigned)_mm256_movemask_epi8(hit);
+        if (m) {
+            return p + SIMD_CTZ32(m);
+        }
+        p += 32;
+    }
+    return find_text_special_sse2(p, end);
+}
+
+static const simd_kernels_t kernels_avx2 = {
+    SIMD_LEVEL_AVX2, "avx2", find1_avx2, find2_avx2, find3_avx2, find_text_special_avx2
+};
+
+SIMD_TARGET("avx512f,avx512bw")
+static const char *find1_avx512(const char *p, const char *end, char a) {
+    const __m512i va = _mm512_set1_epi8(a);
+    while (end - p >= 64) {
+        __m512i x = _mm512_loadu_si512((const void *)p);
+        unsigned long long m = _mm512_cmpeq_epi8_mask(x, va);
+        if (m) {
+            return p + SIMD_CTZ64(m);
+        }
+        p += 64;
+    }
+    return find1_avx2(p, end, a);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+static const char *find2_avx512(const char *p, const char *end, char a, char b) {
+    const __m512i va = _mm512_set1_epi8(a);
+    const __m512i vb = _mm512_set1_epi8(b);
+    while (end - p >= 64) {
+        __m512i x = _mm512_loadu_si512((const void *)p);
+        unsigned long long m = _mm512_cmpeq_epi8_mask(x, va) | _mm512_cmpeq_epi8_mask(x, vb);
+        if (m) {
+            return p + SIMD_CTZ64(m);
+        }
+        p += 64;
+    }
+    return find2_avx2(p, end, a, b);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+static const char *find3_avx512(const char *p, const char *end, char a, char b, char c) {
+    const __m512i va = _mm512_set1_epi8(a);
+    const __m512i vb = _mm512_set1_epi8(b);
+    const __m512i vc = _mm512_set1_epi8(c);
+    while (end - p >= 64) {
+        __m512i x = _mm512_loadu_si512((const void *)p);
+        unsigned long long m = _mm512_cmpeq_epi8_mask(x, va) | _mm512_cmpeq_epi8_mask(x, vb) |
+                               _mm512_cmpeq_epi8_mask(x, vc);
+        if (m) {
+            return p + SIMD_CTZ64(m);
+        }
+        p += 64;
+    }
+    return find3_avx2(p, end, a, b, c);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+static const char *find_text_special_avx512(const char *p, const char *end) {
+    const __m512i amp = _mm512_set1_epi8('&');
+    const __m512i space = _mm512_set1_epi8(' ');
+    const __m512i tab = _mm512_set1_epi8(0x09);
+    const __m512i four = _mm512_set1_epi8(0x04);
+    while (end - p > 64) {
+        __m512i x = _mm512_loadu_si512((const void *)p);
+        __m512i next = _mm512_loadu_si512((const void *)(p + 1));
+        unsigned long long next_space = _mm512_cmpeq_epi8_mask(next, space) |
+                                        _mm512_cmple_epu8_mask(_mm512_sub_epi8(next, tab), four);
+        unsigned long long m = _mm512_cmpeq_epi8_mask(x, amp) |
+                               _mm512_cmple_epu8_mask(_mm512_sub_epi8(x, tab), four) |
+                               (_mm512_cmpeq_epi8_mask(x, space) & next_space);
+        if (m) {
+            return p + SIMD_CTZ64(m);
+        }
+        p += 64;
+    }
+    return find_text_special_avx2(p, end);
+}
+
+static const simd_kernels_t kernels_avx512 = {
+    SIMD_LEVEL_AVX512, "avx512", find1_avx512, find2_avx512, find3_avx512, find_text_special_avx512
+};
+
+#endif
+
+static simd_level_t detect_level(void) {
+#if defined(SIMD_SCAN_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f")) {
+        return SIMD_LEVEL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_LEVEL_AVX2;
+    }
+    return SIMD_LEVEL_SSE2;
+#elif defined(SIMD_SCAN_X86)
+    return SIMD_LEVEL_SSE2;
+#else
+    return SIMD_LEVEL_SCALAR;
+#endif
+}
+
+static simd_level_t env_level_cap(void) {
+    const char *env = getenv("HABR_SIMD");
+    if (!env) {
+        return SIMD_LEVEL_AVX512;
+    }
+    if (strcmp(env, "scalar") == 0) {
+        return SIMD_LEVEL_SCALAR;
+    }
+    if (strcmp(env, "sse2") == 0) {
+        return SIMD_LEVEL_SSE2;
+    }
+    if (strcmp(env, "avx2") == 0) {
+        return SIMD_LEVEL_AVX2;
+    }
+    return SIMD_LEVEL_AVX512;
+}
+
+const simd_kernels_t *simd_scan_kernels_for(simd_level_t level) {
+    simd_level_t best = detect_level();
+    if (level > best) {
+        level = best;
+    }
+    switch (level) {
+#ifdef SIMD_SCAN_DISPATCH
+        case SIMD_LEVEL_AVX512:
+            return &kernels_avx512;
+        case SIMD_LEVEL_AVX2:
+            return &kernels_avx2;
+#endif
+#ifdef SIMD_SCAN_X86
+        case SIMD_LEVEL_SSE2:
+            return &kernels_sse2;
+#endif
+        default:
+            return &kernels_scalar;
+    }
+}
+
+/* Scanner threads may race to resolve the kernels; they all store the same
+ * table. */
+const simd_kernels_t *simd_scan_kernels(void) {
+    static const simd_kernels_t *_Atomic resolved = NULL;
+    const simd_kernels_t *kernels = atomic_load_explicit(&resolved, memory_order_acquire);
+    if (!kernels) {
+        kernels = simd_scan_kernels_for(env_level_cap());
+        atomic_store_explicit(&resolved, kernels, memory_order_release);
+    }
+    return kernels;
+}
@@ -0,0 +1,34 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+typedef enum {
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE2,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_AVX512
+} simd_level_t;
+
+/*
+ * Byte search kernels. Each returns a pointer to the first byte in [p, end)
+ * equal to one of the needles, or `end` when there is none.
+ *
+ * find_text_special() instead stops at the first byte text normalization
+ * has to rewrite: '&', whitespace other than ' ', or a ' ' that is followed
+ * by whitespace or by `end`.
+ */
+typedef struct {
+    simd_level_t level;
+    const char *name;
+    const char *(*find1)(const char *p, const char *end, char a);
+    const char *(*find2)(const char *p, const char *end, char a, char b);
+    const char *(*find3)(const char *p, const char *end, char a, char b, char c);
+    const char *(*find_text_special)(const char *p, const char *end);
+} simd_kernels_t;
+
+/* Best kernels for the running CPU. HABR_SIMD=scalar|sse2|avx2|avx512 caps the level. */
+const simd_kernels_t *simd_scan_kernels(void);
+const simd_kernels_t *simd_scan_kernels_for(simd_level_t level);
+
+#endif
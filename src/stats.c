@@ -0,0 +1,169 @@
+#include "stats.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+void stats_init(stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void stats_free(stats_t *stats) {
+    free(stats->latencies_ms);
+    stats->latencies_ms = NULL;
+    stats->latency_len = 0;
+    stats->latency_cap = 0;
+}
+
+void stats_record_latency(stats_t *stats, double ms) {
+    if (!stats) {
+        return;
+    }
+    if (stats->latency_len == stats->latency_cap) {
+        size_t cap = stats->latency_cap ? stats->latency_cap * 2 : 64;
+        double *grown = (double *)realloc(stats->latencies_ms, cap * sizeof(double));
+        if (!grown) {
+            return;
+        }
+        stats->latencies_ms = grown;
+        stats->latency_cap = cap;
+    }
+    stats->latencies_ms[stats->latency_len++] = ms;
+}
+
+void stats_record_retry(stats_t *stats, long backoff_ms) {
+    if (!stats) {
+        return;
+    }
+    stats->http_retries++;
+    stats->backoff_ms += backoff_ms;
+}
+
+void stats_merge(stats_t *into, const stats_t *from) {
+    into->http_requests += from->http_requests;
+    into->http_failures += from->http_failures;
+    into->http_cancelled += from->http_cancelled;
+    into->http_retries += from->http_retries;
+    into->http_bytes += from->http_bytes;
+    into->local_responses += from->local_responses;
+    into->backoff_ms += from->backoff_ms;
+    for (size_t i = 0; i < from->latency_len; ++i) {
+        stats_record_latency(into, from->latencies_ms[i]);
+    }
+    into->scan_bytes += from->scan_bytes;
+    into->scan_tokens += from->scan_tokens;
+    into->articles_emitted += from->articles_emitted;
+    into->articles_incomplete += from->articles_incomplete;
+    into->articles_duplicate += from->articles_duplicate;
+    into->bytes_written += from->bytes_written;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile; sorts the samples on first use. */
+static double percentile(stats_t *stats, double p) {
+    if (stats->latency_len == 0) {
+        return 0;
+    }
+    qsort(stats->latencies_ms, stats->latency_len, sizeof(double), compare_double);
+    double exact = p * (double)stats->latency_len;
+    size_t rank = (size_t)exact;
+    if ((double)rank < exact) {
+        rank++;
+    }
+    return stats->latencies_ms[rank > 0 ? rank - 1 : 0];
+}
+
+static double latency_sum(const stats_t *stats) {
+    double sum = 0;
+    for (size_t i = 0; i < stats->latency_len; ++i) {
+        sum += stats->latencies_ms[i];
+    }
+    return sum;
+}
+
+static long long extract_us(const stats_t *stats) {
+    long long us = stats->parse_us - stats->write_us;
+    return us > 0 ? us : 0;
+}
+
+static long long other_us(const stats_t *stats) {
+    long long us = stats->wall_us - stats->parse_us;
+    return us > 0 ? us : 0;
+}
+
+void stats_print_json(stats_t *stats, FILE *out) {
+    fprintf(out,
+            "{\"wall_ms\": %.3f,\n"
+            " \"http\": {\"requests\": %llu, \"failures\": %llu, \"cancelled\": %llu, \"retries\": %llu, "
+            "\"backoff_ms\": %lld, \"bytes\": %llu, \"local_responses\": %llu,\n"
+            "          \"latency_ms\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}},\n"
+            " \"scanner\": {\"bytes\": %llu, \"tokens\": %llu},\n"
+            " \"extractor\": {\"articles_emitted\": %llu, \"articles_dropped_incomplete\": %llu, "
+            "\"articles_dropped_duplicate\": %llu},\n"
+            " \"writer\": {\"bytes\": %llu},\n"
+            " \"stages_ms\": {\"extract\": %.3f, \"write\": %.3f, \"fetch_and_other\": %.3f}}\n",
+            stats->wall_us / 1000.0,
+            stats->http_requests, stats->http_failures, stats->http_cancelled, stats->http_retries,
+            stats->backoff_ms, stats->http_bytes, stats->local_responses,
+            percentile(stats, 0.50), percentile(stats, 0.90), percentile(stats, 0.99), percentile(stats, 1.0),
+            stats->scan_bytes, stats->scan_tokens,
+            stats->articles_emitted, stats->articles_incomplete, stats->articles_duplicate,
+            stats->bytes_written,
+            extract_us(stats) / 1000.0, stats->write_us / 1000.0, other_us(stats) / 1000.0);
+}
+
+static void prom_counter(FILE *fp, const char *name, const char *help, unsigned long long value) {
+    fprintf(fp, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name, value);
+}
+
+static void prom_seconds(FILE *fp, const char *name, const char *help, const char *type, long long us) {
+    fprintf(fp, "# HELP %s %s\n# TYPE %s %s\n%s %.6f\n", name, help, name, type, name, us / 1e6);
+}
+
+int stats_write_prometheus(stats_t *stats, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    prom_counter(fp, "habr_http_requests_total", "HTTP request attempts.", stats->http_requests);
+    prom_counter(fp, "habr_http_failures_total", "HTTP attempts that did not succeed.", stats->http_failures);
+    prom_counter(fp, "habr_http_cancelled_total", "HTTP transfers abandoned once their data was not needed.",
+                 stats->http_cancelled);
+    prom_counter(fp, "habr_http_retries_total", "HTTP attempts that were retried.", stats->http_retries);
+    prom_seconds(fp, "habr_http_backoff_seconds_total", "Time spent backing off before retries.", "counter",
+                 stats->backoff_ms * 1000);
+    prom_counter(fp, "habr_http_bytes_total", "Response body bytes downloaded.", stats->http_bytes);
+    prom_counter(fp, "habr_http_local_responses_total", "Responses served from the cache or a replay archive.",
+                 stats->local_responses);
+    fprintf(fp, "# HELP habr_http_latency_seconds HTTP request latency.\n# TYPE habr_http_latency_seconds summary\n");
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i) {
+        fprintf(fp, "habr_http_latency_seconds{quantile=\"%g\"} %.6f\n", quantiles[i],
+                percentile(stats, quantiles[i]) / 1000.0);
+    }
+    fprintf(fp, "habr_http_latency_seconds_sum %.6f\nhabr_http_latency_seconds_count %zu\n",
+            latency_sum(stats) / 1000.0, stats->latency_len);
+    prom_counter(fp, "habr_scan_bytes_total", "HTML bytes fed to the scanner.", stats->scan_bytes);
+    prom_counter(fp, "habr_scan_tokens_total", "Tokens emitted by the scanner.", stats->scan_tokens);
+    prom_counter(fp, "habr_articles_emitted_total", "Articles written.", stats->articles_emitted);
+    prom_counter(fp, "habr_articles_dropped_incomplete_total", "Articles dropped without a title or URL.",
+                 stats->articles_incomplete);
+    prom_counter(fp, "habr_articles_dropped_duplicate_total", "Articles dropped as repeats of a retried page.",
+                 stats->articles_duplicate);
+    prom_counter(fp, "habr_output_bytes_total", "Bytes written to the output.", stats->bytes_written);
+    prom_seconds(fp, "habr_wall_seconds", "Wall time of the run.", "gauge", stats->wall_us);
+    prom_seconds(fp, "habr_extract_seconds_total", "Time spent scanning and extracting.", "counter",
+                 extract_us(stats));
+    prom_seconds(fp, "habr_write_seconds_total", "Time spent writing output.", "counter", stats->write_us);
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Run-wide counters and stage timers for --stats. Components hold a
+ * `stats_t *` that is NULL when stats are off, so the disabled cost is one
+ * predictable branch per request or per document. Per-token and per-byte
+ * counts are kept in the scanner and flushed here once per document.
+ */
+typedef struct {
+    unsigned long long http_requests;
+    unsigned long long http_failures;
+    unsigned long long http_cancelled;
+    unsigned long long http_retries;
+    unsigned long long http_bytes;
+    unsigned long long local_responses;
+    long long backoff_ms;
+    double *latencies_ms;
+    size_t latency_len;
+    size_t latency_cap;
+
+    unsigned long long scan_bytes;
+    unsigned long long scan_tokens;
+    unsigned long long articles_emitted;
+    unsigned long long articles_incomplete;
+    unsigned long long articles_duplicate;
+    unsigned long long bytes_written;
+
+    long long wall_us;
+    long long parse_us;
+    long long write_us;
+} stats_t;
+
+void stats_init(stats_t *stats);
+void stats_free(stats_t *stats);
+void stats_record_latency(stats_t *stats, double ms);
+void stats_record_retry(stats_t *stats, long backoff_ms);
+/* Adds the counters and latencies of `from`, e.g. one worker's, to `into`.
+ * Timers are left alone: workers overlap, so their times do not add up. */
+void stats_merge(stats_t *into, const stats_t *from);
+void stats_print_json(stats_t *stats, FILE *out);
+int stats_write_prometheus(stats_t *stats, const char *path);
+
+#endif
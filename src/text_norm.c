@@ -0,0 +1,77 @@
+#include "text_norm.h"
+
+#include <string.h>
+
+#include "entities.h"
+#include "simd_scan.h"
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+size_t text_normalize(char *str, size_t len, bool collapse_decoded) {
+    const simd_kernels_t *kernels = simd_scan_kernels();
+    char *dst = str;
+    const char *src = str;
+    const char *end = str + len;
+    bool pending_space = false;
+    /* Bytes entities have saved so far. Expanding references only fit within
+     * this, exactly as when entities_decode() runs on the collapsed text. */
+    size_t decode_room = 0;
+    while (src < end) {
+        if (is_space(*src)) {
+            while (src < end && is_space(*src)) {
+                ++src;
+            }
+            /* A plain run may already end in the single space. */
+            pending_space = dst > str && !(collapse_decoded && dst[-1] == ' ');
+            continue;
+        }
+        if (*src == '&') {
+            char value[ENTITIES_VALUE_MAX];
+            size_t value_len = 0;
+            size_t used = entities_match(src, (size_t)(end - src), value, &value_len);
+            if (used == 0 || value_len > used + decode_room) {
+                value[0] = '&';
+                value_len = 1;
+                used = 1;
+            } else {
+                decode_room = decode_room + used - value_len;
+                if (src[1] != '#' && value_len == 2 && memcmp(value, "\xC2\xA0", 2) == 0) {
+                    /* Named no-break spaces stay plain spaces in the output. */
+                    value[0] = ' ';
+                    value_len = 1;
+                }
+            }
+            src += used;
+            for (size_t i = 0; i < value_len; ++i) {
+                if (collapse_decoded && is_space(value[i])) {
+                    pending_space = dst > str && dst[-1] != ' ';
+                    continue;
+                }
+                if (pending_space) {
+                    *dst++ = ' ';
+                    pending_space = false;
+                }
+                *dst++ = value[i];
+            }
+            continue;
+        }
+        if (pending_space) {
+            *dst++ = ' ';
+            pending_space = false;
+        }
+        /* Plain bytes, single spaces between words included, stay as they are. */
+        const char *stop = kernels->find_text_special(src, end);
+        size_t run = (size_t)(stop - src);
+        if (dst != src) {
+            memmove(dst, src, run);
+        }
+        dst += run;
+        src = stop;
+    }
+    if (collapse_decoded && dst > str && dst[-1] == ' ') {
+        --dst;
+    }
+    return (size_t)(dst - str);
+}
@@ -0,0 +1,17 @@
+#ifndef TEXT_NORM_H
+#define TEXT_NORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Normalizes extracted text in place, in one forward pass. The result is the
+ * same as collapsing whitespace runs (newlines included) to single spaces,
+ * trimming both ends and then decoding entities. Named no-break spaces such
+ * as "&nbsp;" decode to a plain space; "&#160;" still gives U+00A0. With
+ * `collapse_decoded`, whitespace the entities decode to is collapsed and
+ * trimmed as well. Returns the new length; the result is not NUL-terminated.
+ */
+size_t text_normalize(char *str, size_t len, bool collapse_decoded);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef HABR_HAVE_THREADS_H
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "thread.h"
+
+#ifdef HABR_HAVE_THREADS_H
+
+static int run_thread(void *arg) {
+    thread_t *thread = (thread_t *)arg;
+    return thread->fn(thread->arg);
+}
+
+bool thread_start(thread_t *thread, thread_fn fn, void *arg) {
+    thread->fn = fn;
+    thread->arg = arg;
+    return thrd_create(&thread->handle, run_thread, thread) == thrd_success;
+}
+
+void thread_join(thread_t *thread) {
+    thrd_join(thread->handle, NULL);
+}
+
+bool thread_mutex_init(thread_mutex_t *mutex) {
+    return mtx_init(&mutex->handle, mtx_plain) == thrd_success;
+}
+
+void thread_mutex_destroy(thread_mutex_t *mutex) {
+    mtx_destroy(&mutex->handle);
+}
+
+void thread_mutex_lock(thread_mutex_t *mutex) {
+    mtx_lock(&mutex->handle);
+}
+
+void thread_mutex_unlock(thread_mutex_t *mutex) {
+    mtx_unlock(&mutex->handle);
+}
+
+bool thread_cond_init(thread_cond_t *cond) {
+    return cnd_init(&cond->handle) == thrd_success;
+}
+
+void thread_cond_destroy(thread_cond_t *cond) {
+    cnd_destroy(&cond->handle);
+}
+
+void thread_cond_wait(thread_cond_t *cond, thread_mutex_t *mutex) {
+    cnd_wait(&cond->handle, &mutex->handle);
+}
+
+void thread_cond_signal(thread_cond_t *cond) {
+    cnd_signal(&cond->handle);
+}
+
+void thread_cond_broadcast(thread_cond_t *cond) {
+    cnd_broadcast(&cond->handle);
+}
+
+#else
+
+static void *run_thread(void *arg) {
+    thread_t *thread = (thread_t *)arg;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+bool thread_start(thread_t *thread, thread_fn fn, void *arg) {
+    thread->fn = fn;
+    thread->arg = arg;
+    return pthread_create(&thread->handle, NULL, run_thread, thread) == 0;
+}
+
+void thread_join(thread_t *thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+bool thread_mutex_init(thread_mutex_t *mutex) {
+    return pthread_mutex_init(&mutex->handle, NULL) == 0;
+}
+
+void thread_mutex_destroy(thread_mutex_t *mutex) {
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+void thread_mutex_lock(thread_mutex_t *mutex) {
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void thread_mutex_unlock(thread_mutex_t *mutex) {
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+bool thread_cond_init(thread_cond_t *cond) {
+    return pthread_cond_init(&cond->handle, NULL) == 0;
+}
+
+void thread_cond_destroy(thread_cond_t *cond) {
+    pthread_cond_destroy(&cond->handle);
+}
+
+void thread_cond_wait(thread_cond_t *cond, thread_mutex_t *mutex) {
+    pthread_cond_wait(&cond->handle, &mutex->handle);
+}
+
+void thread_cond_signal(thread_cond_t *cond) {
+    pthread_cond_signal(&cond->handle);
+}
+
+void thread_cond_broadcast(thread_cond_t *cond) {
+    pthread_cond_broadcast(&cond->handle);
+}
+
+#endif
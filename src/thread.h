@@ -0,0 +1,57 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdbool.h>
+
+#ifdef HABR_HAVE_THREADS_H
+#include <threads.h>
+#else
+#include <pthread.h>
+#endif
+
+/* Minimal threads: C11 <threads.h> where the C library has it, pthreads
+ * otherwise. */
+typedef int (*thread_fn)(void *arg);
+
+typedef struct {
+#ifdef HABR_HAVE_THREADS_H
+    thrd_t handle;
+#else
+    pthread_t handle;
+#endif
+    thread_fn fn;
+    void *arg;
+} thread_t;
+
+typedef struct {
+#ifdef HABR_HAVE_THREADS_H
+    mtx_t handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} thread_mutex_t;
+
+typedef struct {
+#ifdef HABR_HAVE_THREADS_H
+    cnd_t handle;
+#else
+    pthread_cond_t handle;
+#endif
+} thread_cond_t;
+
+/* `thread` must stay in place until thread_join(). */
+bool thread_start(thread_t *thread, thread_fn fn, void *arg);
+void thread_join(thread_t *thread);
+
+bool thread_mutex_init(thread_mutex_t *mutex);
+void thread_mutex_destroy(thread_mutex_t *mutex);
+void thread_mutex_lock(thread_mutex_t *mutex);
+void thread_mutex_unlock(thread_mutex_t *mutex);
+
+bool thread_cond_init(thread_cond_t *cond);
+void thread_cond_destroy(thread_cond_t *cond);
+void thread_cond_wait(thread_cond_t *cond, thread_mutex_t *mutex);
+void thread_cond_signal(thread_cond_t *cond);
+void thread_cond_broadcast(thread_cond_t *cond);
+
+#endif
@@ -7,6 +7,7 @@
 #endif
 
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -60,43 +61,44 @@ bool utils_strcasestr_bool(const char *haystack, const char *needle) {
     return false;
 }
 
-int utils_parse_attr(const char *attrs, const char *name, char *out, size_t out_cap) {
+int utils_parse_attr(const char *attrs, size_t attrs_len, const char *name, char *out, size_t out_cap) {
     if (!attrs || !name || !out || out_cap == 0) {
         return 0;
     }
     const char *p = attrs;
+    const char *end = attrs + attrs_len;
     size_t name_len = strlen(name);
-    while (*p) {
-        while (*p && utils_is_space(*p)) {
+    while (p < end) {
+        while (p < end && utils_is_space(*p)) {
             ++p;
         }
-        if (!*p || *p == '>') {
+        if (p >= end || *p == '>') {
             break;
         }
         const char *key_start = p;
-        while (*p && !utils_is_space(*p) && *p != '=' && *p != '>') {
+        while (p < end && !utils_is_space(*p) && *p != '=' && *p != '>') {
             ++p;
         }
         size_t key_len = (size_t)(p - key_start);
         const char *after_key = p;
-        while (*p && utils_is_space(*p)) {
+        while (p < end && utils_is_space(*p)) {
             ++p;
         }
-        if (*p != '=') {
+        if (p >= end || *p != '=') {
             p = after_key;
             continue;
         }
         ++p;
-        while (*p && utils_is_space(*p)) {
+        while (p < end && utils_is_space(*p)) {
             ++p;
         }
         char quote = '\0';
-        if (*p == '"' || *p == '\'') {
+        if (p < end && (*p == '"' || *p == '\'')) {
             quote = *p;
             ++p;
         }
         const char *value_start = p;
-        while (*p) {
+        while (p < end) {
             if (quote) {
                 if (*p == quote) {
                     break;
@@ -107,7 +109,7 @@ int utils_parse_attr(const char *attrs, const char *name, char *out, size_t out_
             ++p;
         }
         const char *value_end = p;
-        if (quote && *p == quote) {
+        if (quote && p < end && *p == quote) {
             ++p;
         }
         if (key_len == name_len && utils_strncasecmp_local(key_start, name, name_len) == 0) {
@@ -123,15 +125,29 @@ int utils_parse_attr(const char *attrs, const char *name, char *out, size_t out_
     return 0;
 }
 
-bool utils_class_contains(const char *attrs, const char *needle) {
+bool utils_class_contains(const char *attrs, size_t attrs_len, const char *needle) {
     if (!attrs || !needle) {
         return false;
     }
     char class_buf[512];
-    if (!utils_parse_attr(attrs, "class", class_buf, sizeof(class_buf))) {
+    if (!utils_parse_attr(attrs, attrs_len, "class", class_buf, sizeof(class_buf))) {
         return false;
     }
-    return strstr(class_buf, needle) != NULL;
+    size_t needle_len = strlen(needle);
+    const char *p = class_buf;
+    while (*p) {
+        while (*p && utils_is_space(*p)) {
+            ++p;
+        }
+        const char *start = p;
+        while (*p && !utils_is_space(*p)) {
+            ++p;
+        }
+        if ((size_t)(p - start) == needle_len && needle_len > 0 && memcmp(start, needle, needle_len) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void utils_trim(char *str) {
@@ -153,25 +169,31 @@ void utils_trim(char *str) {
     str[len] = '\0';
 }
 
-void utils_normalize_whitespace(char *str) {
-    if (!str) {
-        return;
-    }
-    char *dst = str;
-    bool in_space = false;
-    for (char *src = str; *src; ++src) {
-        if (utils_is_space(*src)) {
+size_t utils_collapse_whitespace(char *str, size_t len) {
+    size_t out = 0;
+    bool in_space = true;
+    for (size_t i = 0; i < len; ++i) {
+        if (utils_is_space(str[i])) {
             if (!in_space) {
-                *dst++ = ' ';
+                str[out++] = ' ';
                 in_space = true;
             }
         } else {
-            *dst++ = *src;
+            str[out++] = str[i];
             in_space = false;
         }
     }
-    *dst = '\0';
-    utils_trim(str);
+    if (out > 0 && in_space) {
+        --out;
+    }
+    return out;
+}
+
+void utils_normalize_whitespace(char *str) {
+    if (!str) {
+        return;
+    }
+    str[utils_collapse_whitespace(str, strlen(str))] = '\0';
 }
 
 void utils_replace_newlines_with_space(char *str) {
@@ -185,6 +207,67 @@ void utils_replace_newlines_with_space(char *str) {
     }
 }
 
+void utils_sb_init(utils_sb_t *sb) {
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+}
+
+void utils_sb_free(utils_sb_t *sb) {
+    free(sb->data);
+    utils_sb_init(sb);
+}
+
+void utils_sb_clear(utils_sb_t *sb) {
+    sb->len = 0;
+    if (sb->data) {
+        sb->data[0] = '\0';
+    }
+}
+
+bool utils_sb_reserve(utils_sb_t *sb, size_t extra) {
+    if (extra < sb->cap - sb->len) {
+        return true;
+    }
+    size_t cap = sb->cap ? sb->cap : 64;
+    while (cap - sb->len <= extra) {
+        cap *= 2;
+    }
+    char *grown = (char *)realloc(sb->data, cap);
+    if (!grown) {
+        return false;
+    }
+    if (!sb->data) {
+        grown[0] = '\0';
+    }
+    sb->data = grown;
+    sb->cap = cap;
+    return true;
+}
+
+bool utils_sb_append(utils_sb_t *sb, const char *data, size_t len) {
+    if (!utils_sb_reserve(sb, len)) {
+        return false;
+    }
+    if (len > 0) {
+        memcpy(sb->data + sb->len, data, len);
+    }
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+    return true;
+}
+
+bool utils_sb_append_char(utils_sb_t *sb, char ch) {
+    return utils_sb_append(sb, &ch, 1);
+}
+
+void utils_sb_truncate(utils_sb_t *sb, size_t len) {
+    if (len < sb->len) {
+        sb->len = len;
+        sb->data[len] = '\0';
+    }
+}
+
 bool utils_safe_append_char(char *dest, size_t cap, char ch) {
     size_t len = strlen(dest);
     if (len + 1 >= cap) {
@@ -209,6 +292,19 @@ bool utils_safe_append(char *dest, size_t cap, const char *src) {
     return dest_len + src_len < cap - 1;
 }
 
+bool utils_safe_append_n(char *dest, size_t cap, const char *src, size_t src_len) {
+    if (!dest || (!src && src_len > 0)) {
+        return false;
+    }
+    size_t dest_len = strlen(dest);
+    if (dest_len + src_len >= cap) {
+        src_len = cap - dest_len - 1;
+    }
+    memcpy(dest + dest_len, src, src_len);
+    dest[dest_len + src_len] = '\0';
+    return dest_len + src_len < cap - 1;
+}
+
 bool utils_copy_string(char *dest, size_t cap, const char *src) {
     if (!dest || cap == 0) {
         return false;
@@ -236,6 +332,31 @@ void utils_sleep_ms(long ms) {
 #endif
 }
 
+long long utils_now_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000L;
+#endif
+}
+
+long long utils_now_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / freq.QuadPart * 1000000LL +
+                       counter.QuadPart % freq.QuadPart * 1000000LL / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000L;
+#endif
+}
+
 bool utils_urlencode(const char *input, char *output, size_t cap) {
     if (!input || !output || cap == 0) {
         return false;
@@ -266,27 +387,20 @@ bool utils_urlencode(const char *input, char *output, size_t cap) {
     return true;
 }
 
-void utils_make_absolute_url(const char *href, char *out, size_t cap) {
-    if (!href || !out || cap == 0) {
-        return;
-    }
-    if (strncmp(href, "http://", 7) == 0 || strncmp(href, "https://", 8) == 0) {
-        utils_copy_string(out, cap, href);
-        return;
-    }
-    if (href[0] == '/') {
-        const char *prefix = "https://habr.com";
-        size_t needed = strlen(prefix) + strlen(href) + 1;
-        if (needed > cap) {
-            utils_copy_string(out, cap, "https://habr.com");
-            size_t remain = cap - strlen(out) - 1;
-            strncat(out, href, remain);
-        } else {
-            snprintf(out, cap, "%s%s", prefix, href);
+size_t utils_make_absolute_url(const char *href, size_t href_len, char *out, size_t cap) {
+    const char *prefix = (href_len > 0 && href[0] == '/') ? "https://habr.com" : "";
+    size_t prefix_len = strlen(prefix);
+    size_t total = prefix_len + href_len;
+    if (out && cap > 0) {
+        size_t n = prefix_len < cap - 1 ? prefix_len : cap - 1;
+        memcpy(out, prefix, n);
+        size_t m = href_len < cap - 1 - n ? href_len : cap - 1 - n;
+        if (m > 0) {
+            memcpy(out + n, href, m);
         }
-    } else {
-        utils_copy_string(out, cap, href);
+        out[n + m] = '\0';
     }
+    return total;
 }
 
 void utils_replace_char(char *str, char from, char to) {
@@ -300,3 +414,38 @@ void utils_replace_char(char *str, char from, char to) {
     }
 }
 
+int utils_read_file(const char *path, char **out_data, size_t *out_size) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    long length = ftell(fp);
+    if (length < 0) {
+        fclose(fp);
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    char *buffer = (char *)malloc((size_t)length + 1);
+    if (!buffer) {
+        fclose(fp);
+        return -1;
+    }
+    size_t read = fread(buffer, 1, (size_t)length, fp);
+    fclose(fp);
+    buffer[read] = '\0';
+    if (out_data) {
+        *out_data = buffer;
+    }
+    if (out_size) {
+        *out_size = read;
+    }
+    return 0;
+}
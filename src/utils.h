@@ -4,20 +4,50 @@
 #include <stddef.h>
 #include <stdbool.h>
 
-int utils_parse_attr(const char *attrs, const char *name, char *out, size_t out_cap);
-bool utils_class_contains(const char *attrs, const char *needle);
+/* Growable string that tracks its length, so appends never rescan it.
+ * `data` is NUL-terminated once anything has been allocated; on allocation
+ * failure an append leaves the builder unchanged and returns false. */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} utils_sb_t;
+
+void utils_sb_init(utils_sb_t *sb);
+void utils_sb_free(utils_sb_t *sb);
+void utils_sb_clear(utils_sb_t *sb);
+/* Makes room for `extra` more bytes and the NUL. */
+bool utils_sb_reserve(utils_sb_t *sb, size_t extra);
+bool utils_sb_append(utils_sb_t *sb, const char *data, size_t len);
+bool utils_sb_append_char(utils_sb_t *sb, char ch);
+/* Shortens the string to `len` bytes, e.g. after rewriting it in place. */
+void utils_sb_truncate(utils_sb_t *sb, size_t len);
+
+int utils_parse_attr(const char *attrs, size_t attrs_len, const char *name, char *out, size_t out_cap);
+bool utils_class_contains(const char *attrs, size_t attrs_len, const char *needle);
 void utils_trim(char *str);
 void utils_normalize_whitespace(char *str);
+/* Collapses whitespace runs of `len` bytes to single spaces and trims both
+ * ends, in place and in one pass. Returns the new length. */
+size_t utils_collapse_whitespace(char *str, size_t len);
 void utils_replace_newlines_with_space(char *str);
 bool utils_safe_append(char *dest, size_t cap, const char *src);
+bool utils_safe_append_n(char *dest, size_t cap, const char *src, size_t src_len);
 bool utils_safe_append_char(char *dest, size_t cap, char ch);
 bool utils_copy_string(char *dest, size_t cap, const char *src);
 int utils_strcasecmp_local(const char *a, const char *b);
 int utils_strncasecmp_local(const char *a, const char *b, size_t n);
 bool utils_strcasestr_bool(const char *haystack, const char *needle);
 void utils_sleep_ms(long ms);
+long long utils_now_ms(void);
+long long utils_now_us(void);
+/* Reads a whole file into a NUL-terminated malloc'ed buffer; -1 on error,
+ * reported on stderr when the file cannot be opened. */
+int utils_read_file(const char *path, char **out_data, size_t *out_size);
 bool utils_urlencode(const char *input, char *output, size_t cap);
-void utils_make_absolute_url(const char *href, char *out, size_t cap);
+/* Like snprintf: writes at most cap - 1 bytes plus a NUL and returns the
+ * full length of the absolute URL. */
+size_t utils_make_absolute_url(const char *href, size_t href_len, char *out, size_t cap);
 void utils_replace_char(char *str, char from, char to);
 
 #endif
@@ -0,0 +1,203 @@
+#include "writer.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread.h"
+
+/*
+ * Single-producer, single-consumer ring of batches. Slots move between the
+ * two sides through `head` and `tail` alone; the mutex is only taken to
+ * sleep on an empty or full ring and to wake the other side. A submitted
+ * batch is swapped with the drained one in its slot, so its arena blocks
+ * go back to the submitter for reuse.
+ */
+struct writer_queue {
+    writer_t *writer;
+    article_batch_t *slots;
+    size_t depth;
+    /* Next slot to write; advanced by the thread. */
+    atomic_size_t head;
+    /* Next slot to fill; advanced by the submitter. */
+    atomic_size_t tail;
+    bool stopping;
+    thread_mutex_t lock;
+    thread_cond_t ready;
+    thread_cond_t space;
+    thread_t thread;
+};
+
+static const writer_ops_t *const builtin_formats[] = {
+    &writer_csv_ops,
+    &writer_jsonl_ops,
+    &writer_arrow_ops,
+};
+
+const writer_ops_t *writer_find(const char *name) {
+    for (size_t i = 0; i < sizeof(builtin_formats) / sizeof(builtin_formats[0]); ++i) {
+        if (strcmp(builtin_formats[i]->name, name) == 0) {
+            return builtin_formats[i];
+        }
+    }
+    return NULL;
+}
+
+static void queue_free(writer_queue_t *queue) {
+    for (size_t i = 0; i < queue->depth; ++i) {
+        article_batch_free(&queue->slots[i]);
+    }
+    free(queue->slots);
+    free(queue);
+}
+
+static int queue_run(void *arg) {
+    writer_queue_t *queue = (writer_queue_t *)arg;
+    for (;;) {
+        size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        if (atomic_load_explicit(&queue->tail, memory_order_acquire) == head) {
+            thread_mutex_lock(&queue->lock);
+            while (atomic_load_explicit(&queue->tail, memory_order_acquire) == head && !queue->stopping) {
+                thread_cond_wait(&queue->ready, &queue->lock);
+            }
+            bool drained = atomic_load_explicit(&queue->tail, memory_order_acquire) == head;
+            thread_mutex_unlock(&queue->lock);
+            if (drained) {
+                return 0;
+            }
+        }
+        article_batch_t *slot = &queue->slots[head % queue->depth];
+        queue->writer->ops->write_batch(queue->writer, slot);
+        article_batch_clear(slot);
+        atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+        thread_mutex_lock(&queue->lock);
+        thread_cond_signal(&queue->space);
+        thread_mutex_unlock(&queue->lock);
+    }
+}
+
+static void queue_submit(writer_queue_t *queue, article_batch_t *batch) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&queue->head, memory_order_acquire) == queue->depth) {
+        thread_mutex_lock(&queue->lock);
+        while (tail - atomic_load_explicit(&queue->head, memory_order_acquire) == queue->depth) {
+            thread_cond_wait(&queue->space, &queue->lock);
+        }
+        thread_mutex_unlock(&queue->lock);
+    }
+    article_batch_t *slot = &queue->slots[tail % queue->depth];
+    article_batch_t drained = *slot;
+    *slot = *batch;
+    *batch = drained;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    thread_mutex_lock(&queue->lock);
+    thread_cond_signal(&queue->ready);
+    thread_mutex_unlock(&queue->lock);
+}
+
+/* Waits for the thread to write everything submitted, then stops it. */
+static void queue_stop(writer_t *writer) {
+    writer_queue_t *queue = writer->queue;
+    if (!queue) {
+        return;
+    }
+    thread_mutex_lock(&queue->lock);
+    queue->stopping = true;
+    thread_cond_signal(&queue->ready);
+    thread_mutex_unlock(&queue->lock);
+    thread_join(&queue->thread);
+    thread_cond_destroy(&queue->space);
+    thread_cond_destroy(&queue->ready);
+    thread_mutex_destroy(&queue->lock);
+    queue_free(queue);
+    writer->queue = NULL;
+}
+
+bool writer_init(writer_t *writer, const writer_ops_t *ops, FILE *file) {
+    writer->ops = ops;
+    writer->state = NULL;
+    writer->queue = NULL;
+    if (!output_init(&writer->out, file)) {
+        return false;
+    }
+    if (ops->init && !ops->init(writer)) {
+        output_free(&writer->out);
+        return false;
+    }
+    return true;
+}
+
+void writer_free(writer_t *writer) {
+    queue_stop(writer);
+    if (writer->ops->free) {
+        writer->ops->free(writer);
+    }
+    output_free(&writer->out);
+}
+
+void writer_begin(writer_t *writer) {
+    if (writer->ops->begin) {
+        writer->ops->begin(writer);
+    }
+}
+
+void writer_write_batch(writer_t *writer, const article_batch_t *batch) {
+    writer->ops->write_batch(writer, batch);
+}
+
+void writer_submit_batch(writer_t *writer, article_batch_t *batch) {
+    if (writer->queue) {
+        queue_submit(writer->queue, batch);
+        return;
+    }
+    writer->ops->write_batch(writer, batch);
+    article_batch_clear(batch);
+}
+
+bool writer_start_thread(writer_t *writer, size_t depth) {
+    if (depth == 0) {
+        return false;
+    }
+    writer_queue_t *queue = (writer_queue_t *)calloc(1, sizeof(*queue));
+    if (!queue) {
+        return false;
+    }
+    queue->slots = (article_batch_t *)calloc(depth, sizeof(*queue->slots));
+    if (!queue->slots) {
+        free(queue);
+        return false;
+    }
+    queue->writer = writer;
+    queue->depth = depth;
+    for (size_t i = 0; i < depth; ++i) {
+        article_batch_init(&queue->slots[i]);
+    }
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    bool locked = thread_mutex_init(&queue->lock);
+    bool ready = locked && thread_cond_init(&queue->ready);
+    bool space = ready && thread_cond_init(&queue->space);
+    if (space && thread_start(&queue->thread, queue_run, queue)) {
+        writer->queue = queue;
+        return true;
+    }
+    if (space) {
+        thread_cond_destroy(&queue->space);
+    }
+    if (ready) {
+        thread_cond_destroy(&queue->ready);
+    }
+    if (locked) {
+        thread_mutex_destroy(&queue->lock);
+    }
+    queue_free(queue);
+    return false;
+}
+
+int writer_end(writer_t *writer) {
+    queue_stop(writer);
+    if (writer->ops->end) {
+        writer->ops->end(writer);
+    }
+    return output_flush(&writer->out);
+}
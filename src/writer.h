@@ -0,0 +1,60 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "article.h"
+#include "output.h"
+
+typedef struct writer writer_t;
+
+/*
+ * An output format. `begin` runs before the first batch and `end` after the
+ * last, e.g. for headers and footers; `state` belongs to the format, which
+ * sets it up in `init` and releases it in `free`. Both may be NULL.
+ */
+typedef struct {
+    const char *name;
+    bool (*init)(writer_t *writer);
+    void (*begin)(writer_t *writer);
+    void (*write_batch)(writer_t *writer, const article_batch_t *batch);
+    void (*end)(writer_t *writer);
+    void (*free)(writer_t *writer);
+} writer_ops_t;
+
+typedef struct writer_queue writer_queue_t;
+
+struct writer {
+    const writer_ops_t *ops;
+    output_t out;
+    void *state;
+    /* Set while batches are written on a separate thread. */
+    writer_queue_t *queue;
+};
+
+extern const writer_ops_t writer_csv_ops;
+extern const writer_ops_t writer_jsonl_ops;
+extern const writer_ops_t writer_arrow_ops;
+
+/* Built-in format by name: "csv", "jsonl" or "arrow"; NULL if unknown. */
+const writer_ops_t *writer_find(const char *name);
+/* Returns false when out of memory. */
+bool writer_init(writer_t *writer, const writer_ops_t *ops, FILE *file);
+void writer_free(writer_t *writer);
+void writer_begin(writer_t *writer);
+void writer_write_batch(writer_t *writer, const article_batch_t *batch);
+/* Moves the batch out to the writer and leaves `batch` empty. */
+void writer_submit_batch(writer_t *writer, article_batch_t *batch);
+/*
+ * Writes submitted batches on a separate thread from now on, so slow output
+ * does not hold up the caller. Up to `depth` batches wait in a ring between
+ * the two; when it is full, submitting blocks until the thread catches up.
+ * writer_end() drains the ring and stops the thread. Returns false if the
+ * thread could not be started; writing then stays synchronous.
+ */
+bool writer_start_thread(writer_t *writer, size_t depth);
+/* Ends the output and flushes it; -1 if anything failed to write. */
+int writer_end(writer_t *writer);
+
+#endif
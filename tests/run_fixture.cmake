@@ -0,0 +1,18 @@
+# Runs habr_parser on one fixture page and compares the CSV with the expected
+# file. Called by ctest with PARSER, INPUT, EXPECTED and OUTPUT set.
+execute_process(
+    COMMAND ${PARSER} --input ${INPUT}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "habr_parser failed on ${INPUT}: ${result}")
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()
@@ -0,0 +1,234 @@
+/*
+ * Generates the named character reference table used by src/entities.c.
+ *
+ * Usage: gen_entities tools/html_entities.txt entities_table.c
+ *
+ * The build runs this on every change to the entity list. The table is a
+ * hash-and-displace perfect hash over the names, the same scheme as
+ * src/html_tags.c, with values stored as UTF-8.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/entities_table.h"
+
+#define MAX_ENTITIES 4096
+#define BUCKETS 1024
+#define SLOTS 4096
+#define SLOT_SHIFT 20
+
+typedef struct {
+    char name[ENTITIES_NAME_MAX + 1];
+    size_t name_len;
+    unsigned char value[ENTITIES_VALUE_MAX];
+    size_t value_len;
+    uint32_t hash;
+} entry_t;
+
+static entry_t entries[MAX_ENTITIES];
+static size_t entry_count;
+static uint16_t disp[BUCKETS];
+static uint16_t slots[SLOTS];
+
+static uint32_t fnv(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t slot_of(uint32_t hash, uint32_t d) {
+    return ((hash ^ d) * 0x9E3779B1u) >> SLOT_SHIFT;
+}
+
+static size_t encode_utf8(unsigned long cp, unsigned char *out) {
+    if (cp < 0x80) {
+        out[0] = (unsigned char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (unsigned char)(0xC0 | (cp >> 6));
+        out[1] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (unsigned char)(0xE0 | (cp >> 12));
+        out[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (unsigned char)(0xF0 | (cp >> 18));
+    out[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (unsigned char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static int parse_line(char *line, int line_no) {
+    char *token = strtok(line, " \t\r\n");
+    if (!token || token[0] == '#') {
+        return 0;
+    }
+    if (entry_count == MAX_ENTITIES) {
+        fprintf(stderr, "line %d: too many entities\n", line_no);
+        return -1;
+    }
+    entry_t *entry = &entries[entry_count];
+    entry->name_len = strlen(token);
+    if (entry->name_len > ENTITIES_NAME_MAX) {
+        fprintf(stderr, "line %d: name longer than ENTITIES_NAME_MAX\n", line_no);
+        return -1;
+    }
+    memcpy(entry->name, token, entry->name_len + 1);
+    entry->value_len = 0;
+    while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+        unsigned long cp = strtoul(token, NULL, 16);
+        if (entry->value_len + 4 > ENTITIES_VALUE_MAX || cp > 0x10FFFF) {
+            fprintf(stderr, "line %d: value does not fit ENTITIES_VALUE_MAX\n", line_no);
+            return -1;
+        }
+        entry->value_len += encode_utf8(cp, entry->value + entry->value_len);
+    }
+    if (entry->value_len == 0) {
+        fprintf(stderr, "line %d: missing code points\n", line_no);
+        return -1;
+    }
+    entry->hash = fnv(entry->name, entry->name_len);
+    entry_count++;
+    return 0;
+}
+
+static int read_entities(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int line_no = 0;
+    int rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), in)) {
+        rc = parse_line(line, ++line_no);
+    }
+    fclose(in);
+    return rc;
+}
+
+static int build(void) {
+    static size_t members[BUCKETS][64];
+    static size_t sizes[BUCKETS];
+    static size_t order[BUCKETS];
+    for (size_t i = 0; i < entry_count; ++i) {
+        size_t b = entries[i].hash % BUCKETS;
+        if (sizes[b] == 64) {
+            fprintf(stderr, "bucket %zu overflows\n", b);
+            return -1;
+        }
+        members[b][sizes[b]++] = i;
+    }
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        order[b] = b;
+    }
+    /* Largest buckets first; insertion sort is plenty for this size. */
+    for (size_t i = 1; i < BUCKETS; ++i) {
+        size_t b = order[i];
+        size_t j = i;
+        while (j > 0 && sizes[order[j - 1]] < sizes[b]) {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = b;
+    }
+    for (size_t k = 0; k < BUCKETS && sizes[order[k]] > 0; ++k) {
+        size_t b = order[k];
+        uint32_t d = 0;
+        for (; d <= UINT16_MAX; ++d) {
+            uint32_t wanted[64];
+            int ok = 1;
+            for (size_t m = 0; m < sizes[b] && ok; ++m) {
+                wanted[m] = slot_of(entries[members[b][m]].hash, d);
+                ok = slots[wanted[m]] == 0;
+                for (size_t n = 0; n < m && ok; ++n) {
+                    ok = wanted[n] != wanted[m];
+                }
+            }
+            if (ok) {
+                for (size_t m = 0; m < sizes[b]; ++m) {
+                    slots[wanted[m]] = (uint16_t)(members[b][m] + 1);
+                }
+                break;
+            }
+        }
+        if (d > UINT16_MAX) {
+            fprintf(stderr, "no displacement for bucket %zu\n", b);
+            return -1;
+        }
+        disp[b] = (uint16_t)d;
+    }
+    return 0;
+}
+
+static void write_table(FILE *out) {
+    fprintf(out, "/* Generated by tools/gen_entities.c from tools/html_entities.txt; do not edit. */\n");
+    fprintf(out, "#include \"entities_table.h\"\n\n#include <stdint.h>\n#include <string.h>\n\n");
+    fprintf(out, "typedef struct {\n    const char *name;\n    uint8_t name_len;\n    uint8_t value_len;\n"
+                 "    const char *value;\n} entity_t;\n\n");
+    fprintf(out, "static const entity_t entity_items[%zu] = {\n", entry_count);
+    for (size_t i = 0; i < entry_count; ++i) {
+        const entry_t *entry = &entries[i];
+        fprintf(out, "    {\"%s\", %zu, %zu, \"", entry->name, entry->name_len, entry->value_len);
+        for (size_t v = 0; v < entry->value_len; ++v) {
+            fprintf(out, "\\x%02X", entry->value[v]);
+        }
+        fprintf(out, "\"},\n");
+    }
+    fprintf(out, "};\n\nstatic const uint16_t entity_disp[%d] = {\n", BUCKETS);
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        fprintf(out, "%s%5u,%s", i % 12 == 0 ? "    " : " ", disp[i], i % 12 == 11 || i + 1 == BUCKETS ? "\n" : "");
+    }
+    fprintf(out, "};\n\n/* Index into entity_items plus one; zero marks an empty slot. */\n");
+    fprintf(out, "static const uint16_t entity_slots[%d] = {\n", SLOTS);
+    for (size_t i = 0; i < SLOTS; ++i) {
+        fprintf(out, "%s%4u,%s", i % 12 == 0 ? "    " : " ", slots[i], i % 12 == 11 || i + 1 == SLOTS ? "\n" : "");
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out,
+            "bool entities_table_lookup(const char *name, size_t len, const char **value, size_t *value_len) {\n"
+            "    uint32_t hash = 2166136261u;\n"
+            "    for (size_t i = 0; i < len; ++i) {\n"
+            "        hash = (hash ^ (unsigned char)name[i]) * 16777619u;\n"
+            "    }\n"
+            "    uint16_t slot = entity_slots[((hash ^ entity_disp[hash %% %d]) * 0x9E3779B1u) >> %d];\n"
+            "    if (slot == 0) {\n"
+            "        return false;\n"
+            "    }\n"
+            "    const entity_t *entity = &entity_items[slot - 1];\n"
+            "    if (entity->name_len != len || memcmp(entity->name, name, len) != 0) {\n"
+            "        return false;\n"
+            "    }\n"
+            "    *value = entity->value;\n"
+            "    *value_len = entity->value_len;\n"
+            "    return true;\n"
+            "}\n",
+            BUCKETS, SLOT_SHIFT);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <html_entities.txt> <output.c>\n", argv[0]);
+        return 1;
+    }
+    if (read_entities(argv[1]) != 0 || build() != 0) {
+        return 1;
+    }
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s\n", argv[2]);
+        return 1;
+    }
+    write_table(out);
+    return fclose(out) == 0 ? 0 : 1;
+}
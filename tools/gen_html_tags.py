@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Regenerates the perfect-hash tables in src/html_tags.c.
+
+Usage: tools/gen_html_tags.py > src/html_tags.c
+
+The element names come from the HTML_TAG_LIST macro in src/html_tags.h, so
+adding a tag means adding it there and rerunning this script.
+"""
+
+import os
+import re
+import sys
+
+BUCKETS = 64
+SLOTS = 256
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+
+def read_tags():
+    header = os.path.join(os.path.dirname(__file__), "..", "src", "html_tags.h")
+    with open(header) as f:
+        text = f.read()
+    return re.findall(r'X\((\w+), "([a-z0-9]+)"\)', text)
+
+
+def fnv(name):
+    h = FNV_OFFSET
+    for c in name.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def slot(h, d):
+    return (((h ^ d) * 0x9E3779B1) & 0xFFFFFFFF) >> 24
+
+
+def build(tags):
+    buckets = [[] for _ in range(BUCKETS)]
+    for ident, name in tags:
+        h = fnv(name)
+        buckets[h % BUCKETS].append((ident, name, h))
+    disp = [0] * BUCKETS
+    slots = [None] * SLOTS
+    for b in sorted(range(BUCKETS), key=lambda i: -len(buckets[i])):
+        if not buckets[b]:
+            continue
+        for d in range(SLOTS):
+            wanted = [slot(h, d) for _, _, h in buckets[b]]
+            if len(set(wanted)) == len(wanted) and all(slots[s] is None for s in wanted):
+                disp[b] = d
+                for s, entry in zip(wanted, buckets[b]):
+                    slots[s] = entry
+                break
+        else:
+            sys.exit("no displacement for bucket %d" % b)
+    return disp, slots
+
+
+def main():
+    tags = read_tags()
+    disp, slots = build(tags)
+    out = sys.stdout
+    out.write("/* Generated by tools/gen_html_tags.py; do not edit. */\n")
+    out.write('#include "html_tags.h"\n\n#include <string.h>\n\n')
+    out.write("#define HTML_TAG_BUCKETS %d\n#define HTML_TAG_SLOTS %d\n\n" % (BUCKETS, SLOTS))
+    out.write("static const char *const tag_names[HTML_TAG_COUNT] = {\n")
+    out.write('    [HTML_TAG_UNKNOWN] = "",\n')
+    out.write("#define X(id, name) [HTML_TAG_##id] = name,\n")
+    out.write("    HTML_TAG_LIST(X)\n#undef X\n};\n\n")
+    out.write("static const uint8_t tag_lengths[HTML_TAG_COUNT] = {\n")
+    out.write("#define X(id, name) [HTML_TAG_##id] = sizeof(name) - 1,\n")
+    out.write("    HTML_TAG_LIST(X)\n#undef X\n};\n\n")
+    out.write("static const uint8_t tag_disp[HTML_TAG_BUCKETS] = {\n")
+    for i in range(0, BUCKETS, 16):
+        out.write("    " + ", ".join("%3d" % d for d in disp[i:i + 16]) + ",\n")
+    out.write("};\n\n")
+    out.write("static const uint8_t tag_slots[HTML_TAG_SLOTS] = {\n")
+    for i, entry in enumerate(slots):
+        if entry is not None:
+            out.write("    [%d] = HTML_TAG_%s,\n" % (i, entry[0]))
+    out.write("};\n\n")
+    out.write(TAIL)
+
+
+TAIL = """html_tag_t html_tag_lookup_hashed(const char *name, size_t len, uint32_t hash) {
+    uint32_t slot = ((hash ^ tag_disp[hash % HTML_TAG_BUCKETS]) * 0x9E3779B1u) >> 24;
+    html_tag_t id = (html_tag_t)tag_slots[slot];
+    if (tag_lengths[id] != len || memcmp(tag_names[id], name, len) != 0) {
+        return HTML_TAG_UNKNOWN;
+    }
+    return id;
+}
+
+html_tag_t html_tag_lookup(const char *name, size_t len) {
+    uint32_t hash = HTML_TAG_HASH_INIT;
+    for (size_t i = 0; i < len; ++i) {
+        hash = HTML_TAG_HASH_STEP(hash, (unsigned char)name[i]);
+    }
+    return html_tag_lookup_hashed(name, len, hash);
+}
+
+const char *html_tag_name(html_tag_t id) {
+    return (unsigned)id < HTML_TAG_COUNT ? tag_names[id] : "";
+}
+"""
+
+if __name__ == "__main__":
+    main()